@@ -0,0 +1,716 @@
+/*
+ * Copyright (C) 2010 Hiroyuki Ikezoe
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * pointingstickd runs the driver's stick processing outside the X server:
+ * it grabs the evdev node, feeds it through the same core the Xorg module
+ * uses on a thread of its own, and re-emits the result through uinput, so
+ * a busy server does not stall the pointer and Wayland sessions get the
+ * scrolling and press to select behaviour too.
+ *
+ * Options are the ones of the Xorg module, taken from xorg.conf style
+ * files (every Option "Name" "Value" line is read) and from -o Name=Value.
+ */
+
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+
+#include "pointingstick-core.h"
+#include "trackpoint-sysfs.h"
+
+#define LONG_BITS (sizeof(long) * 8)
+#define NLONGS(x) (((x) + LONG_BITS - 1) / LONG_BITS)
+#define TestBit(bit, array) ((array[(bit) / LONG_BITS]) & (1L << ((bit) % LONG_BITS)))
+#define SYSCALL(call) while (((call) == -1) && (errno == EINTR))
+
+#define UINPUT_NAME "pointingstickd virtual pointer"
+#define MAX_OPTIONS 64
+
+typedef struct _Option
+{
+    char *name;
+    char *value;
+} Option;
+
+typedef struct _Daemon
+{
+    const char *device_path;
+    char name[256];
+    int fd;
+    int uinput_fd;
+    int stop_fd;
+    int priority;
+    Option options[MAX_OPTIONS];
+    int noptions;
+    char *trackpoint_sysfs_path;
+    PointingStickCore core;
+    double motion_remainder[2];
+} Daemon;
+
+/* Option names compare like xf86NameCmp(): no case, no '_' or ' '. */
+static int
+name_equal (const char *a, const char *b)
+{
+    for (;;) {
+        while (*a == '_' || *a == ' ')
+            a++;
+        while (*b == '_' || *b == ' ')
+            b++;
+        if (tolower((unsigned char)*a) != tolower((unsigned char)*b))
+            return 0;
+        if (!*a)
+            return 1;
+        a++;
+        b++;
+    }
+}
+
+static int
+add_option (Daemon *daemon, const char *name, const char *value)
+{
+    int i;
+
+    for (i = 0; i < daemon->noptions; i++) {
+        if (name_equal(daemon->options[i].name, name)) {
+            free(daemon->options[i].value);
+            daemon->options[i].value = strdup(value);
+            return 0;
+        }
+    }
+
+    if (daemon->noptions == MAX_OPTIONS)
+        return -1;
+
+    daemon->options[daemon->noptions].name = strdup(name);
+    daemon->options[daemon->noptions].value = strdup(value);
+    daemon->noptions++;
+    return 0;
+}
+
+static const char *
+find_option (Daemon *daemon, const char *name)
+{
+    int i;
+
+    for (i = 0; i < daemon->noptions; i++) {
+        if (name_equal(daemon->options[i].name, name))
+            return daemon->options[i].value;
+    }
+    return NULL;
+}
+
+static int
+int_option (Daemon *daemon, const char *name, int default_value)
+{
+    const char *value = find_option(daemon, name);
+
+    return value ? atoi(value) : default_value;
+}
+
+static int
+bool_option (Daemon *daemon, const char *name, int default_value)
+{
+    const char *value = find_option(daemon, name);
+
+    if (!value)
+        return default_value;
+
+    if (name_equal(value, "on") || name_equal(value, "true") ||
+        name_equal(value, "yes") || !strcmp(value, "1"))
+        return 1;
+    if (name_equal(value, "off") || name_equal(value, "false") ||
+        name_equal(value, "no") || !strcmp(value, "0"))
+        return 0;
+
+    fprintf(stderr, "ignoring invalid boolean \"%s\" for %s\n", value, name);
+    return default_value;
+}
+
+/* Picks up every Option "Name" "Value" line, comments stripped. */
+static int
+read_config (Daemon *daemon, const char *path)
+{
+    FILE *file;
+    char line[1024];
+
+    file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file)) {
+        char name[256], value[256];
+        char *comment = strchr(line, '#');
+
+        if (comment)
+            *comment = '\0';
+        if (sscanf(line, " Option \"%255[^\"]\" \"%255[^\"]\"", name, value) == 2)
+            add_option(daemon, name, value);
+    }
+
+    fclose(file);
+    return 0;
+}
+
+static int
+parse_option_argument (Daemon *daemon, const char *argument)
+{
+    char *name = strdup(argument);
+    char *value = strchr(name, '=');
+    int ret = -1;
+
+    if (value) {
+        *value++ = '\0';
+        ret = add_option(daemon, name, value);
+    }
+    free(name);
+    return ret;
+}
+
+/* Same checks as is_pointingstick() in the Xorg module. */
+static int
+probe_device (Daemon *daemon)
+{
+    unsigned long evbits[NLONGS(EV_MAX)] = {0};
+    unsigned long bits[NLONGS(KEY_MAX)] = {0};
+    int rc, has_abs_events;
+
+    SYSCALL(rc = ioctl(daemon->fd, EVIOCGBIT(0, sizeof(evbits)), evbits));
+    if (rc < 0 || !TestBit(EV_SYN, evbits) || !TestBit(EV_KEY, evbits))
+        return -1;
+
+    if (TestBit(EV_ABS, evbits)) {
+        SYSCALL(rc = ioctl(daemon->fd, EVIOCGBIT(EV_ABS, sizeof(bits)), bits));
+        if (rc < 0 || !TestBit(ABS_X, bits) || !TestBit(ABS_Y, bits) ||
+            !TestBit(ABS_PRESSURE, bits))
+            return -1;
+        has_abs_events = 1;
+    } else if (TestBit(EV_REL, evbits)) {
+        SYSCALL(rc = ioctl(daemon->fd, EVIOCGBIT(EV_REL, sizeof(bits)), bits));
+        if (rc < 0 || !TestBit(REL_X, bits) || !TestBit(REL_Y, bits))
+            return -1;
+        has_abs_events = 0;
+    } else {
+        return -1;
+    }
+
+    SYSCALL(rc = ioctl(daemon->fd, EVIOCGNAME(sizeof(daemon->name) - 1), daemon->name));
+    if (rc < 0)
+        return -1;
+
+    if (!has_abs_events) {
+        const char *root = find_option(daemon, "SysfsRoot");
+
+        if (!root)
+            root = getenv(TRACKPOINT_SYSFS_ROOT_ENV);
+        daemon->trackpoint_sysfs_path =
+            trackpoint_sysfs_find(root ? root : TRACKPOINT_SYSFS_ROOT, daemon->name);
+    }
+
+    pointingstick_core_init(&daemon->core, has_abs_events,
+                            daemon->trackpoint_sysfs_path != NULL);
+    return 0;
+}
+
+static void
+set_trackpoint_attribute (Daemon *daemon, const char *attribute, int value)
+{
+    if (trackpoint_sysfs_set_attribute(daemon->trackpoint_sysfs_path,
+                                       attribute, value) < 0)
+        fprintf(stderr, "cannot set %s/%s\n", daemon->trackpoint_sysfs_path, attribute);
+}
+
+static void
+apply_trackpoint_option (Daemon *daemon, const char *option, const char *attribute)
+{
+    const char *value = find_option(daemon, option);
+
+    if (value)
+        set_trackpoint_attribute(daemon, attribute, atoi(value));
+}
+
+/*
+ * Options of the Xorg module the daemon has no equivalent for: the device
+ * is always grabbed, the psmouse rate and resolution are left alone,
+ * acceleration is up to the compositor and there is no telemetry.
+ */
+static void
+warn_unsupported_options (Daemon *daemon)
+{
+    static const char *unsupported[] = {
+        "ExclusiveGrab", "AccelProfile", "AdaptiveRate", "IdleRate",
+        "ActiveRate", "RateIdleTimeout", "Resolution", "Telemetry"
+    };
+    unsigned int i;
+
+    for (i = 0; i < sizeof(unsupported) / sizeof(unsupported[0]); i++) {
+        if (find_option(daemon, unsupported[i]))
+            fprintf(stderr, "ignoring option %s, not supported by the daemon\n",
+                    unsupported[i]);
+    }
+}
+
+/* Mirrors set_default_values() in the Xorg module. */
+static void
+apply_options (Daemon *daemon)
+{
+    PointingStickCore *core = &daemon->core;
+    int press_to_select;
+
+    warn_unsupported_options(daemon);
+
+    if (core->is_trackpoint) {
+        /* the firmware does the work, the options go to sysfs */
+        apply_trackpoint_option(daemon, "Sensitivity", "sensitivity");
+        apply_trackpoint_option(daemon, "Speed", "speed");
+        press_to_select = bool_option(daemon, "PressToSelect", -1);
+        if (press_to_select >= 0)
+            set_trackpoint_attribute(daemon, "press_to_select", press_to_select);
+        apply_trackpoint_option(daemon, "PressToSelectThreshold", "thresh");
+        core->sensitivity =
+            trackpoint_sysfs_get_attribute(daemon->trackpoint_sysfs_path, "sensitivity");
+        core->press_to_select =
+            trackpoint_sysfs_get_attribute(daemon->trackpoint_sysfs_path, "press_to_select") > 0;
+        core->press_to_select_threshold =
+            trackpoint_sysfs_get_attribute(daemon->trackpoint_sysfs_path, "thresh");
+    } else {
+        core->sensitivity = int_option(daemon, "Sensitivity", core->sensitivity);
+        core->press_to_select = bool_option(daemon, "PressToSelect", core->press_to_select);
+        core->press_to_select_threshold = int_option(daemon, "PressToSelectThreshold",
+                                                     core->press_to_select_threshold);
+        core->press_to_select_release_threshold =
+            int_option(daemon, "PressToSelectReleaseThreshold",
+                       core->press_to_select_threshold * 3 / 4);
+        core->press_to_select_dwell = int_option(daemon, "PressToSelectDwell",
+                                                 core->press_to_select_dwell);
+    }
+
+    core->middle_button_timeout = int_option(daemon, "MiddleButtonTimeout",
+                                             core->middle_button_timeout);
+    core->scroll_distance = int_option(daemon, "ScrollDistance", core->scroll_distance);
+    core->scroll_max_rate = int_option(daemon, "ScrollMaxRate", core->scroll_max_rate);
+    core->motion_rate = int_option(daemon, "MotionRate", core->motion_rate);
+    core->latency_budget = int_option(daemon, "LatencyBudget", core->latency_budget);
+    core->prediction_horizon = int_option(daemon, "PredictionHorizon", core->prediction_horizon);
+    core->drift_compensation = bool_option(daemon, "DriftCompensation",
+                                           core->drift_compensation);
+
+    if (core->sensitivity < 1 || core->sensitivity > 255)
+        core->sensitivity = core->has_abs_events ? 100 : 255;
+    if (core->scroll_distance < 1)
+        core->scroll_distance = 1;
+    if (core->scroll_max_rate < 0)
+        core->scroll_max_rate = 0;
+    if (core->motion_rate < 0)
+        core->motion_rate = 0;
+}
+
+static int
+create_uinput_device (void)
+{
+    static const int keys[] = { BTN_LEFT, BTN_RIGHT, BTN_MIDDLE };
+    static const int axes[] = { REL_X, REL_Y, REL_WHEEL, REL_HWHEEL };
+    struct uinput_user_dev dev;
+    unsigned int i;
+    int fd;
+
+    fd = open("/dev/uinput", O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "cannot open /dev/uinput: %s\n", strerror(errno));
+        return -1;
+    }
+
+    if (ioctl(fd, UI_SET_EVBIT, EV_KEY) < 0 ||
+        ioctl(fd, UI_SET_EVBIT, EV_REL) < 0 ||
+        ioctl(fd, UI_SET_PROPBIT, INPUT_PROP_POINTER) < 0)
+        goto error;
+    for (i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        if (ioctl(fd, UI_SET_KEYBIT, keys[i]) < 0)
+            goto error;
+    }
+    for (i = 0; i < sizeof(axes) / sizeof(axes[0]); i++) {
+        if (ioctl(fd, UI_SET_RELBIT, axes[i]) < 0)
+            goto error;
+    }
+
+    /* must not match the pointingstick InputClass, or X would take it */
+    memset(&dev, 0, sizeof(dev));
+    snprintf(dev.name, sizeof(dev.name), UINPUT_NAME);
+    dev.id.bustype = BUS_VIRTUAL;
+
+    if (write(fd, &dev, sizeof(dev)) != sizeof(dev) ||
+        ioctl(fd, UI_DEV_CREATE) < 0)
+        goto error;
+
+    return fd;
+
+ error:
+    fprintf(stderr, "cannot set up uinput device: %s\n", strerror(errno));
+    close(fd);
+    return -1;
+}
+
+static void
+add_output (struct input_event *out, int *n, int type, int code, int value)
+{
+    memset(&out[*n], 0, sizeof(out[*n]));
+    out[*n].type = type;
+    out[*n].code = code;
+    out[*n].value = value;
+    (*n)++;
+}
+
+/*
+ * uinput only takes whole units, the fraction of the core's motion is
+ * carried over to the next frame instead of being dropped.
+ */
+static void
+add_motion (Daemon *daemon, struct input_event *out, int *n, int axis, double delta)
+{
+    double total = daemon->motion_remainder[axis] + delta;
+    int value = (int)total;
+
+    daemon->motion_remainder[axis] = total - value;
+    if (value)
+        add_output(out, n, EV_REL, axis ? REL_Y : REL_X, value);
+}
+
+/* X button numbers to evdev, 4 to 7 being the legacy scroll buttons. */
+static void
+translate_event (Daemon *daemon, const PointingStickEvent *event,
+                 struct input_event *out, int *n)
+{
+    static const int buttons[] = { 0, BTN_LEFT, BTN_MIDDLE, BTN_RIGHT };
+
+    switch (event->type) {
+    case POINTINGSTICK_EVENT_MOTION:
+        add_motion(daemon, out, n, 0, event->dx);
+        add_motion(daemon, out, n, 1, event->dy);
+        break;
+    case POINTINGSTICK_EVENT_BUTTON:
+        if (event->button <= 3) {
+            add_output(out, n, EV_KEY, buttons[event->button], event->pressed);
+        } else if (event->pressed) {
+            switch (event->button) {
+            case 4:
+                add_output(out, n, EV_REL, REL_WHEEL, 1);
+                break;
+            case 5:
+                add_output(out, n, EV_REL, REL_WHEEL, -1);
+                break;
+            case 6:
+                add_output(out, n, EV_REL, REL_HWHEEL, -1);
+                break;
+            case 7:
+                add_output(out, n, EV_REL, REL_HWHEEL, 1);
+                break;
+            }
+        }
+        break;
+    }
+}
+
+static unsigned int
+now_ms (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int
+forward_events (Daemon *daemon, const PointingStickEvent *events, int n)
+{
+    struct input_event out[POINTINGSTICK_MAX_EVENTS * 2 + 1];
+    int i, nout = 0;
+    ssize_t len;
+
+    if (n == 0)
+        return 0;
+
+    for (i = 0; i < n; i++)
+        translate_event(daemon, &events[i], out, &nout);
+    add_output(out, &nout, EV_SYN, SYN_REPORT, 0);
+
+    SYSCALL(len = write(daemon->uinput_fd, out, nout * sizeof(out[0])));
+    return len < 0 ? -1 : 0;
+}
+
+static int
+forward_frame (Daemon *daemon)
+{
+    PointingStickEvent events[POINTINGSTICK_MAX_EVENTS];
+    int n;
+
+    n = pointingstick_core_process_frame(&daemon->core, now_ms(), events);
+    return forward_events(daemon, events, n);
+}
+
+/*
+ * Motion held back by MotionRate or folded by LatencyBudget, and the
+ * PredictionHorizon overshoot to take back, once due.
+ */
+static int
+forward_pending_motion (Daemon *daemon)
+{
+    PointingStickEvent events[POINTINGSTICK_MAX_EVENTS];
+    unsigned int now = now_ms();
+    int n = 0;
+
+    if (pointingstick_core_motion_delay(&daemon->core, now) == 0)
+        n = pointingstick_core_flush_motion(&daemon->core, now, events);
+    return forward_events(daemon, events, n);
+}
+
+static void *
+process_events (void *data)
+{
+    Daemon *daemon = data;
+    struct pollfd fds[2];
+
+    fds[0].fd = daemon->fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = daemon->stop_fd;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        struct input_event events[64];
+        ssize_t len;
+        int i, timeout, rc;
+
+        timeout = pointingstick_core_motion_delay(&daemon->core, now_ms());
+        rc = poll(fds, 2, timeout);
+        if (rc < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (rc == 0) {
+            if (forward_pending_motion(daemon) < 0) {
+                fprintf(stderr, "uinput write error: %s\n", strerror(errno));
+                return NULL;
+            }
+            continue;
+        }
+        if (fds[1].revents)
+            return NULL;
+
+        len = read(daemon->fd, events, sizeof(events));
+        if (len < 0) {
+            if (errno == EAGAIN || errno == EINTR)
+                continue;
+            if (errno == ENODEV)
+                fprintf(stderr, "%s: device removed\n", daemon->name);
+            else
+                fprintf(stderr, "%s: read error: %s\n", daemon->name, strerror(errno));
+            break;
+        }
+        if (len == 0)
+            break;
+
+        for (i = 0; i < len / (ssize_t)sizeof(events[0]); i++) {
+            if (pointingstick_core_handle_event(&daemon->core, &events[i]) &&
+                forward_frame(daemon) < 0) {
+                fprintf(stderr, "uinput write error: %s\n", strerror(errno));
+                return NULL;
+            }
+        }
+
+        /* motion folded from a backlog goes out once it is read */
+        if (forward_pending_motion(daemon) < 0) {
+            fprintf(stderr, "uinput write error: %s\n", strerror(errno));
+            return NULL;
+        }
+    }
+
+    /* make the main thread return when the device goes away */
+    kill(getpid(), SIGTERM);
+    return NULL;
+}
+
+/* SCHED_FIFO if asked for and permitted, the default policy otherwise. */
+static int
+start_thread (Daemon *daemon, pthread_t *thread)
+{
+    pthread_attr_t attr;
+    struct sched_param param;
+    int rc;
+
+    if (daemon->priority > 0) {
+        pthread_attr_init(&attr);
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        param.sched_priority = daemon->priority;
+        pthread_attr_setschedparam(&attr, &param);
+        rc = pthread_create(thread, &attr, process_events, daemon);
+        pthread_attr_destroy(&attr);
+        if (rc == 0)
+            return 0;
+        fprintf(stderr, "cannot use realtime priority %d: %s\n",
+                daemon->priority, strerror(rc));
+    }
+
+    return pthread_create(thread, NULL, process_events, daemon);
+}
+
+static void
+usage (const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [OPTION]... DEVICE\n"
+            "  -c, --config=FILE        read Option lines from an xorg.conf style file\n"
+            "  -o, --option=NAME=VALUE  set a driver option, e.g. Sensitivity=200\n"
+            "  -p, --priority=N         run the processing thread SCHED_FIFO at N\n",
+            program);
+}
+
+int
+main (int argc, char **argv)
+{
+    static const struct option long_options[] = {
+        { "config", required_argument, NULL, 'c' },
+        { "option", required_argument, NULL, 'o' },
+        { "priority", required_argument, NULL, 'p' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    Daemon daemon;
+    pthread_t thread;
+    sigset_t signals;
+    int c, signum, rc, clock_id;
+
+    memset(&daemon, 0, sizeof(daemon));
+
+    while ((c = getopt_long(argc, argv, "c:o:p:h", long_options, NULL)) != -1) {
+        switch (c) {
+        case 'c':
+            if (read_config(&daemon, optarg) < 0)
+                return 1;
+            break;
+        case 'o':
+            if (parse_option_argument(&daemon, optarg) < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'p':
+            daemon.priority = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    daemon.device_path = argv[optind];
+
+    daemon.fd = open(daemon.device_path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (daemon.fd < 0) {
+        fprintf(stderr, "cannot open %s: %s\n", daemon.device_path, strerror(errno));
+        return 1;
+    }
+
+    if (probe_device(&daemon) < 0) {
+        fprintf(stderr, "%s is not a pointing stick\n", daemon.device_path);
+        return 1;
+    }
+    apply_options(&daemon);
+
+    SYSCALL(rc = ioctl(daemon.fd, EVIOCGRAB, (void *)1));
+    if (rc < 0) {
+        fprintf(stderr, "cannot grab %s: %s\n", daemon.device_path, strerror(errno));
+        return 1;
+    }
+
+#ifdef EVIOCSCLOCKID
+    /* event timestamps on the clock of now_ms(), for LatencyBudget */
+    clock_id = CLOCK_MONOTONIC;
+    SYSCALL(rc = ioctl(daemon.fd, EVIOCSCLOCKID, &clock_id));
+    daemon.core.monotonic_time = (rc == 0);
+#endif
+
+    daemon.uinput_fd = create_uinput_device();
+    if (daemon.uinput_fd < 0)
+        return 1;
+
+    daemon.stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (daemon.stop_fd < 0) {
+        perror("eventfd");
+        return 1;
+    }
+
+    /* only the main thread takes the termination signals */
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    rc = start_thread(&daemon, &thread);
+    if (rc != 0) {
+        fprintf(stderr, "cannot start processing thread: %s\n", strerror(rc));
+        return 1;
+    }
+
+    fprintf(stderr, "%s: processing %s (%s)\n", argv[0], daemon.name,
+            daemon.core.is_trackpoint ? "TrackPoint" : "pointing stick");
+
+    sigwait(&signals, &signum);
+
+    if (eventfd_write(daemon.stop_fd, 1) < 0)
+        perror("eventfd_write");
+    pthread_join(thread, NULL);
+
+    ioctl(daemon.uinput_fd, UI_DEV_DESTROY);
+    close(daemon.uinput_fd);
+    ioctl(daemon.fd, EVIOCGRAB, (void *)0);
+    close(daemon.fd);
+    close(daemon.stop_fd);
+    free(daemon.trackpoint_sysfs_path);
+
+    return 0;
+}
+
+/*
+vi:ts=4:nowrap:ai:expandtab:sw=4
+*/
@@ -35,6 +35,15 @@
 /* BOOL */
 #define POINTINGSTICK_PROP_SCROLLING "PointingStick Scrolling"
 
+/* CARD16, distance per scroll button click, in motion units */
+#define POINTINGSTICK_PROP_SCROLL_DISTANCE "PointingStick Scroll Distance"
+
+/* CARD16, scroll button clicks per second and axis, 0 is unlimited */
+#define POINTINGSTICK_PROP_SCROLL_MAX_RATE "PointingStick Scroll Max Rate"
+
+/* CARD16, motion events posted per second at most, 0 is unlimited */
+#define POINTINGSTICK_PROP_MOTION_RATE "PointingStick Motion Rate"
+
 /* CARD16 */
 #define POINTINGSTICK_PROP_MIDDLE_BUTTON_TIMEOUT "PointingStick Middle Button Timeout"
 
@@ -44,4 +53,40 @@
 /* CARD8 */
 #define POINTINGSTICK_PROP_PRESS_TO_SELECT_THRESHOLD "PointingStick Press to Select Threshold"
 
+/* CARD8, sticks without TrackPoint firmware only */
+#define POINTINGSTICK_PROP_PRESS_TO_SELECT_RELEASE_THRESHOLD "PointingStick Press to Select Release Threshold"
+
+/* CARD16, in milliseconds, sticks without TrackPoint firmware only */
+#define POINTINGSTICK_PROP_PRESS_TO_SELECT_DWELL "PointingStick Press to Select Dwell"
+
+/* BOOL */
+#define POINTINGSTICK_PROP_DRIFT_COMPENSATION "PointingStick Drift Compensation"
+
+/* INT32, 2 values (x, y), read-only, in 1/256 counts per second */
+#define POINTINGSTICK_PROP_DRIFT_BASELINE "PointingStick Drift Baseline"
+
+/* BOOL */
+#define POINTINGSTICK_PROP_ADAPTIVE_RATE "PointingStick Adaptive Rate"
+
+/* CARD8, 2 values (idle, active), in reports per second */
+#define POINTINGSTICK_PROP_REPORT_RATE "PointingStick Report Rate"
+
+/* CARD16, in milliseconds */
+#define POINTINGSTICK_PROP_REPORT_RATE_IDLE_TIMEOUT "PointingStick Report Rate Idle Timeout"
+
+/* CARD8, in counts per millimeter, 0 keeps the current resolution */
+#define POINTINGSTICK_PROP_RESOLUTION "PointingStick Resolution"
+
+/* CARD32, read-only */
+#define POINTINGSTICK_PROP_READ_ERRORS "PointingStick Read Errors"
+
+/* CARD16, in milliseconds, 0 disables */
+#define POINTINGSTICK_PROP_LATENCY_BUDGET "PointingStick Latency Budget"
+
+/* CARD32, read-only, frames whose motion was folded for being late */
+#define POINTINGSTICK_PROP_FOLDED_FRAMES "PointingStick Folded Frames"
+
+/* CARD16, in milliseconds, 0 disables */
+#define POINTINGSTICK_PROP_PREDICTION_HORIZON "PointingStick Prediction Horizon"
+
 #endif
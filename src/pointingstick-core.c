@@ -0,0 +1,727 @@
+/*
+ * Copyright (C) 2010 Hiroyuki Ikezoe
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pointingstick-core.h"
+#include "probes.h"
+
+void
+pointingstick_core_init (PointingStickCore *core,
+                         int has_abs_events,
+                         int is_trackpoint)
+{
+    memset(core, 0, sizeof(*core));
+    core->has_abs_events = has_abs_events;
+    core->is_trackpoint = is_trackpoint;
+    if (!has_abs_events)
+        core->pressure = 1;
+
+    /* defaults for sticks without TrackPoint firmware settings */
+    core->sensitivity = has_abs_events ? 100 : 255;
+    core->scrolling = 1;
+    core->scroll_distance = 1;
+    core->scroll_max_rate = 0;
+    core->middle_button_timeout = 100;
+    core->press_to_select = 0;
+    core->press_to_select_threshold = 8;
+    core->press_to_select_release_threshold = 6;
+    core->press_to_select_dwell = 20;
+}
+
+/*
+ * Feeds one evdev event into the current frame.  Returns 1 when the frame
+ * is complete (SYN_REPORT) and pointingstick_core_process_frame() should be
+ * called.
+ */
+int
+pointingstick_core_handle_event (PointingStickCore *core,
+                                 const struct input_event *ev)
+{
+    int v;
+
+    switch (ev->type) {
+    case EV_SYN:
+        switch (ev->code) {
+        case SYN_REPORT:
+            core->time = ev->time.tv_sec * 1000 + ev->time.tv_usec / 1000;
+            return 1;
+            break;
+        }
+        break;
+    case EV_KEY:
+        v = (ev->value ? 1 : 0);
+        switch (ev->code) {
+        case BTN_LEFT:
+            core->left_button = v;
+            break;
+        case BTN_RIGHT:
+            core->right_button = v;
+            break;
+        case BTN_MIDDLE:
+            core->middle_button = v;
+            break;
+        case BTN_TOOL_FINGER:
+            break;
+        case BTN_TOUCH:
+            core->button_touched = v;
+            if (!v)
+                core->touch_released = 1;
+            break;
+        }
+        break;
+    case EV_REL:
+        switch (ev->code) {
+        case REL_X:
+            core->x += ev->value;
+            break;
+        case REL_Y:
+            core->y += ev->value;
+            break;
+        }
+        break;
+    case EV_ABS:
+        switch (ev->code) {
+        case ABS_X:
+            core->x = ev->value;
+            break;
+        case ABS_Y:
+            core->y = ev->value;
+            break;
+        case ABS_PRESSURE:
+            core->pressure = ev->value;
+            break;
+        }
+        break;
+    }
+    return 0;
+}
+
+static void
+add_motion (PointingStickEvent *events, int *n, double dx, double dy)
+{
+    PointingStickEvent *event = &events[(*n)++];
+
+    event->type = POINTINGSTICK_EVENT_MOTION;
+    event->dx = dx;
+    event->dy = dy;
+}
+
+static void
+flush_motion (PointingStickCore *core, PointingStickEvent *events, int *n)
+{
+    if (!core->motion_pending)
+        return;
+
+    /* motion that cancelled out while held back is not worth an event */
+    if (core->pending_motion[0] != 0 || core->pending_motion[1] != 0)
+        add_motion(events, n, core->pending_motion[0], core->pending_motion[1]);
+    core->pending_motion[0] = 0;
+    core->pending_motion[1] = 0;
+    core->motion_pending = 0;
+}
+
+/*
+ * With motion_rate set, motion is accumulated and posted at most that many
+ * times per second; the front end flushes what is left over with
+ * pointingstick_core_flush_motion() once pointingstick_core_motion_delay()
+ * expires.  Motion of stale frames is accumulated the same way and goes
+ * out with the next fresh frame, or when the front end has drained its
+ * backlog.  Frames without motion, e.g. button changes, queue nothing.
+ */
+static void
+queue_motion (PointingStickCore *core,
+              unsigned int now,
+              PointingStickEvent *events,
+              int *n,
+              double dx,
+              double dy)
+{
+    if (dx == 0 && dy == 0)
+        return;
+
+    core->pending_motion[0] += dx;
+    core->pending_motion[1] += dy;
+    core->motion_pending = 1;
+
+    if (core->stale) {
+        core->folded_frames++;
+        core->folded_frames_changed = 1;
+        return;
+    }
+
+    if (core->motion_rate > 0 &&
+        now - core->motion_posted < 1000u / core->motion_rate)
+        return;
+
+    flush_motion(core, events, n);
+    core->motion_posted = now;
+}
+
+/* Pending motion goes out first so that buttons act where the pointer is. */
+static void
+add_button (PointingStickCore *core,
+            PointingStickEvent *events,
+            int *n,
+            int button,
+            int pressed)
+{
+    PointingStickEvent *event;
+
+    flush_motion(core, events, n);
+
+    event = &events[(*n)++];
+    event->type = POINTINGSTICK_EVENT_BUTTON;
+    event->button = button;
+    event->pressed = pressed;
+}
+
+/* Buttons 1 to 3 are only posted when they change. */
+static void
+set_button (PointingStickCore *core,
+            PointingStickEvent *events,
+            int *n,
+            int button,
+            int pressed)
+{
+    unsigned int mask = 1 << button;
+
+    if (!(core->posted_buttons & mask) == !pressed)
+        return;
+
+    core->posted_buttons ^= mask;
+    add_button(core, events, n, button, pressed);
+}
+
+static void
+add_click (PointingStickCore *core, PointingStickEvent *events, int *n, int button)
+{
+    add_button(core, events, n, button, 1);
+    add_button(core, events, n, button, 0);
+}
+
+static int
+handle_middle_button (PointingStickCore *core,
+                      unsigned int now,
+                      PointingStickEvent *events,
+                      int *n)
+{
+    if (core->middle_button) {
+        if (!core->middle_button_is_pressed) {
+            core->middle_button_is_pressed = 1;
+            core->middle_button_click_expires = core->middle_button_timeout + now;
+            core->scroll_accumulated[0] = 0;
+            core->scroll_accumulated[1] = 0;
+            core->scroll_last_click[0] = now - 1000;
+            core->scroll_last_click[1] = now - 1000;
+            return 1;
+        }
+    } else {
+        int ms;
+
+        if (!core->middle_button_is_pressed)
+            return 0;
+
+        core->middle_button_is_pressed = 0;
+        ms = core->middle_button_click_expires - now;
+        /* 1 for a click, 0 for the end of a scroll; and the time held */
+        PROBE2(middle_button, ms > 0, core->middle_button_timeout - ms);
+        if (ms > 0) {
+            add_click(core, events, n, 2);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Clients using buttons 4 to 7 only see whole clicks.  The distance
+ * scrolled on an axis is accumulated and a click sent each time it reaches
+ * scroll_distance, at most one per frame and, with scroll_max_rate, at most
+ * that many per second.  Distance in excess of a click is not kept as a
+ * backlog.
+ */
+static void
+scroll (PointingStickCore *core,
+        unsigned int now,
+        int axis,
+        double delta,
+        int negative_button,
+        int positive_button,
+        PointingStickEvent *events,
+        int *n)
+{
+    double distance = core->scroll_distance > 0 ? core->scroll_distance : 1;
+    double *accumulated = &core->scroll_accumulated[axis];
+
+    *accumulated += delta;
+    if (*accumulated > -distance && *accumulated < distance)
+        return;
+
+    if (core->scroll_max_rate > 0 &&
+        now - core->scroll_last_click[axis] < 1000u / core->scroll_max_rate) {
+        *accumulated = (*accumulated < 0) ? -distance : distance;
+        return;
+    }
+
+    add_click(core, events, n, (*accumulated < 0) ? negative_button : positive_button);
+    core->scroll_last_click[axis] = now;
+    *accumulated -= (int)(*accumulated / distance) * distance;
+}
+
+void
+pointingstick_core_reset_drift (PointingStickCore *core)
+{
+    int i;
+
+    core->drift_frames = 0;
+    for (i = 0; i < 2; i++) {
+        core->drift_residual[i] = 0;
+        if (core->drift_baseline[i] != 0) {
+            core->drift_baseline[i] = 0;
+            core->drift_baseline_changed = 1;
+        }
+    }
+}
+
+#define DRIFT_MAX_DELTA 2
+#define DRIFT_MAX_RATE 40
+#define DRIFT_LEARN_FRAMES 32
+#define DRIFT_MAX_GAP 1000
+
+/*
+ * A TrackPoint that is not touched may keep creeping by a count in one
+ * direction now and then.  evdev only sends a report when there is
+ * something to report, so drift is a rate over evdev time, not an amount
+ * per report: it is learned in 1/256 counts per second and each report
+ * has baseline * (time since the previous report) taken off.  The
+ * remainder is carried over so that fractional amounts cancel exactly,
+ * and compensation never turns a report around.  Only relative devices
+ * are handled, the Styk dead zone in process_frame() already absorbs a
+ * constant offset.
+ *
+ * Small is not enough to be drift: over DRIFT_LEARN_FRAMES reports every
+ * axis has to keep one direction, vary by at most one count and move at
+ * most DRIFT_MAX_RATE counts per second, as a slow deliberate push
+ * reports a count or more at the full report rate.  Larger motion, or a
+ * stick that falls silent for DRIFT_MAX_GAP ms, drops the baseline so that
+ * it is learned again.
+ *
+ * Returns 0 if nothing is left to post for this frame.
+ */
+static int
+compensate_drift (PointingStickCore *core)
+{
+    int *delta[2] = { &core->x, &core->y };
+    unsigned int elapsed = core->time - core->drift_last_time;
+    int buttons_changed, small;
+    int i, latch = 0;
+
+    if (!core->drift_compensation || core->has_abs_events)
+        return 1;
+
+    buttons_changed = core->left_button != core->last_left_button ||
+                      core->right_button != core->last_right_button ||
+                      core->middle_button != core->last_middle_button;
+    core->last_left_button = core->left_button;
+    core->last_right_button = core->right_button;
+    core->last_middle_button = core->middle_button;
+
+    small = !core->left_button && !core->right_button && !core->middle_button &&
+            abs(core->x) <= DRIFT_MAX_DELTA && abs(core->y) <= DRIFT_MAX_DELTA;
+    if (!small || elapsed > DRIFT_MAX_GAP) {
+        pointingstick_core_reset_drift(core);
+        elapsed = 0;
+    }
+    core->drift_last_time = core->time;
+
+    if (small) {
+        if (core->drift_frames++ == 0) {
+            core->drift_start = core->time - elapsed;
+            for (i = 0; i < 2; i++) {
+                core->drift_sum[i] = 0;
+                core->drift_min[i] = *delta[i];
+                core->drift_max[i] = *delta[i];
+            }
+        }
+        if (core->drift_frames >= DRIFT_LEARN_FRAMES) {
+            core->drift_frames = 0;
+            latch = core->time != core->drift_start;
+        }
+    }
+
+    for (i = 0; small && i < 2; i++) {
+        int v = *delta[i];
+
+        core->drift_sum[i] += v;
+        if (v < core->drift_min[i])
+            core->drift_min[i] = v;
+        if (v > core->drift_max[i])
+            core->drift_max[i] = v;
+
+        if (latch &&
+            (core->drift_max[i] - core->drift_min[i] > 1 ||
+             (core->drift_min[i] < 0 && core->drift_max[i] > 0) ||
+             abs(core->drift_sum[i]) * 1000 >
+             DRIFT_MAX_RATE * (int)(core->time - core->drift_start)))
+            latch = 0;
+    }
+
+    for (i = 0; i < 2; i++) {
+        int v = *delta[i];
+        int out;
+
+        if (latch) {
+            int baseline = core->drift_sum[i] * 256 * 1000 /
+                           (int)(core->time - core->drift_start);
+
+            if (baseline != core->drift_baseline[i]) {
+                core->drift_baseline[i] = baseline;
+                core->drift_baseline_changed = 1;
+            }
+        }
+
+        core->drift_residual[i] += v * 256 -
+                                   core->drift_baseline[i] * (int)elapsed / 1000;
+        out = core->drift_residual[i] / 256;
+        if ((out > 0 && v <= 0) || (out < 0 && v >= 0))
+            out = 0;
+        core->drift_residual[i] -= out * 256;
+        if (core->drift_residual[i] > 255)
+            core->drift_residual[i] = 255;
+        else if (core->drift_residual[i] < -255)
+            core->drift_residual[i] = -255;
+        *delta[i] = out;
+    }
+
+    return buttons_changed || core->middle_button_is_pressed ||
+           core->x != 0 || core->y != 0;
+}
+
+/*
+ * Press-to-select for sticks without TrackPoint firmware.  Pressure has to
+ * rise above press_to_select_threshold to select and fall to
+ * press_to_select_release_threshold to let go, and in either direction it
+ * has to stay there for press_to_select_dwell ms of evdev time, so that
+ * pressure hovering around a threshold does not make button 1 chatter.
+ * Lifting the finger lets go at once.  A stick held still sends no
+ * further frames to finish a dwell on, so its end is also reported through
+ * pointingstick_core_motion_delay() as press_to_select_due, on the clock
+ * of now, for pointingstick_core_flush_motion() to finish it.
+ */
+static int
+press_to_select_dwelling (const PointingStickCore *core)
+{
+    return core->press_to_select_state == POINTINGSTICK_PRESS_TO_SELECT_PRESSING ||
+           core->press_to_select_state == POINTINGSTICK_PRESS_TO_SELECT_RELEASING;
+}
+
+static void
+update_press_to_selecting (PointingStickCore *core)
+{
+    core->press_to_selecting =
+        core->press_to_select_state == POINTINGSTICK_PRESS_TO_SELECT_SELECTING ||
+        core->press_to_select_state == POINTINGSTICK_PRESS_TO_SELECT_RELEASING;
+}
+
+static void
+update_press_to_select (PointingStickCore *core, unsigned int now)
+{
+    int release = core->press_to_select_release_threshold;
+
+    if (core->is_trackpoint || !core->press_to_select) {
+        core->press_to_select_state = POINTINGSTICK_PRESS_TO_SELECT_IDLE;
+        core->press_to_selecting = 0;
+        return;
+    }
+
+    if (release > core->press_to_select_threshold)
+        release = core->press_to_select_threshold;
+
+    if (core->pressure <= 0 || core->touch_released)
+        core->press_to_select_state = POINTINGSTICK_PRESS_TO_SELECT_IDLE;
+
+    switch (core->press_to_select_state) {
+    case POINTINGSTICK_PRESS_TO_SELECT_IDLE:
+        if (core->pressure <= core->press_to_select_threshold)
+            break;
+        core->press_to_select_state = POINTINGSTICK_PRESS_TO_SELECT_PRESSING;
+        core->press_to_select_since = core->time;
+        core->press_to_select_due = now + core->press_to_select_dwell;
+        /* fall through */
+    case POINTINGSTICK_PRESS_TO_SELECT_PRESSING:
+        if (core->pressure <= core->press_to_select_threshold)
+            core->press_to_select_state = POINTINGSTICK_PRESS_TO_SELECT_IDLE;
+        else if (core->time - core->press_to_select_since >= core->press_to_select_dwell)
+            core->press_to_select_state = POINTINGSTICK_PRESS_TO_SELECT_SELECTING;
+        break;
+    case POINTINGSTICK_PRESS_TO_SELECT_SELECTING:
+        if (core->pressure > release)
+            break;
+        core->press_to_select_state = POINTINGSTICK_PRESS_TO_SELECT_RELEASING;
+        core->press_to_select_since = core->time;
+        core->press_to_select_due = now + core->press_to_select_dwell;
+        /* fall through */
+    case POINTINGSTICK_PRESS_TO_SELECT_RELEASING:
+        if (core->pressure > release)
+            core->press_to_select_state = POINTINGSTICK_PRESS_TO_SELECT_SELECTING;
+        else if (core->time - core->press_to_select_since >= core->press_to_select_dwell)
+            core->press_to_select_state = POINTINGSTICK_PRESS_TO_SELECT_IDLE;
+        break;
+    }
+
+    update_press_to_selecting(core);
+}
+
+#define PREDICTION_MAX_DISTANCE 8
+#define PREDICTION_MAX_GAP 50
+
+static int
+prediction_outstanding (const PointingStickCore *core)
+{
+    return core->predicted[0] != 0 || core->predicted[1] != 0;
+}
+
+/*
+ * Extrapolates motion prediction_horizon ms ahead from the velocity of the
+ * recent reports, measured with their evdev timestamps, and bounded to
+ * PREDICTION_MAX_DISTANCE per axis.  Reports within the same ms are added
+ * up until the timestamp moves on, and reports more than
+ * PREDICTION_MAX_GAP ms apart start a new movement.  Only the change of
+ * the prediction is added to the delta, so whatever the previous frame
+ * overshot is taken back by the next one.  If no report follows within two
+ * report periods the stick has stopped and pointingstick_core_flush_motion()
+ * takes the prediction back.
+ */
+static void
+predict_motion (PointingStickCore *core,
+                unsigned int now,
+                double *dx,
+                double *dy)
+{
+    double *delta[2] = { dx, dy };
+    unsigned int interval = core->time - core->last_motion_time;
+    int i;
+
+    if (core->prediction_horizon == 0 && !prediction_outstanding(core)) {
+        core->last_motion_time = core->time;
+        return;
+    }
+
+    for (i = 0; i < 2; i++) {
+        double prediction = 0;
+
+        core->recent_motion[i] += *delta[i];
+        if (interval > PREDICTION_MAX_GAP) {
+            core->velocity[i] = 0;
+            core->recent_motion[i] = 0;
+        } else if (interval > 0) {
+            core->velocity[i] = (core->velocity[i] +
+                                 core->recent_motion[i] / interval) / 2;
+            core->recent_motion[i] = 0;
+        }
+
+        if (core->prediction_horizon > 0 && !core->stale) {
+            prediction = core->velocity[i] * core->prediction_horizon;
+            if (prediction > PREDICTION_MAX_DISTANCE)
+                prediction = PREDICTION_MAX_DISTANCE;
+            else if (prediction < -PREDICTION_MAX_DISTANCE)
+                prediction = -PREDICTION_MAX_DISTANCE;
+        }
+
+        *delta[i] += prediction - core->predicted[i];
+        core->predicted[i] = prediction;
+    }
+
+    if (interval > 0) {
+        core->last_motion_time = core->time;
+        if (interval > PREDICTION_MAX_GAP)
+            interval = PREDICTION_MAX_GAP;
+        core->prediction_expires = now + 2 * interval;
+    }
+}
+
+static int
+process_frame (PointingStickCore *core,
+               unsigned int now,
+               PointingStickEvent *events)
+{
+    double dx, dy;
+    int n = 0;
+
+    if (!compensate_drift(core))
+        return 0;
+
+    /*
+     * A frame older than the latency budget is a leftover of a stall: its
+     * buttons are still posted in order, its motion is folded.
+     */
+    core->stale = core->latency_budget > 0 && core->monotonic_time &&
+                  (int)(now - core->time) > (int)core->latency_budget;
+
+    update_press_to_select(core, now);
+    set_button(core, events, &n, 1, core->left_button || core->press_to_selecting);
+    set_button(core, events, &n, 3, core->right_button);
+
+    if (core->scrolling) {
+        if (handle_middle_button(core, now, events, &n))
+            return n;
+    } else {
+        set_button(core, events, &n, 2, core->middle_button);
+    }
+
+    if (core->pressure <= 0 || core->pressure > 250)
+        return n;
+
+    if (core->is_trackpoint) {
+        dx = core->x * core->pressure;
+        dy = core->y * core->pressure;
+    } else {
+        core->x = (abs(core->x) <= 2) ? 0 : core->x;
+        core->y = (abs(core->y) <= 2) ? 0 : core->y;
+        dx = (double)core->x * core->pressure / (256 - core->sensitivity);
+        dy = (double)core->y * core->pressure / (256 - core->sensitivity);
+    }
+
+    if (!core->scrolling || !core->middle_button_is_pressed) {
+        predict_motion(core, now, &dx, &dy);
+        queue_motion(core, now, events, &n, dx, dy);
+        return n;
+    }
+
+    scroll(core, now, 1, dy, 4, 5, events, &n);
+    scroll(core, now, 0, dx, 6, 7, events, &n);
+
+    return n;
+}
+
+/*
+ * Turns the completed frame into pointer events, at most
+ * POINTINGSTICK_MAX_EVENTS of them.  now is a millisecond clock.  Returns
+ * the number of events stored, 0 if there is nothing to post.
+ */
+int
+pointingstick_core_process_frame (PointingStickCore *core,
+                                  unsigned int now,
+                                  PointingStickEvent *events)
+{
+    int n;
+
+    n = process_frame(core, now, events);
+    core->touch_released = 0;
+
+    /* relative deltas are per frame, absolute positions persist */
+    if (!core->has_abs_events) {
+        core->x = 0;
+        core->y = 0;
+    }
+
+    return n;
+}
+
+/*
+ * Moves motion held back by motion_rate, and a prediction that is due to
+ * be taken back, into events, and finishes a press-to-select dwell that is
+ * over.  Returns the number of events stored, at most 2.
+ */
+int
+pointingstick_core_flush_motion (PointingStickCore *core,
+                                 unsigned int now,
+                                 PointingStickEvent *events)
+{
+    int n = 0;
+
+    if (press_to_select_dwelling(core) &&
+        (int)(now - core->press_to_select_due) >= 0) {
+        if (core->press_to_select_state == POINTINGSTICK_PRESS_TO_SELECT_PRESSING)
+            core->press_to_select_state = POINTINGSTICK_PRESS_TO_SELECT_SELECTING;
+        else
+            core->press_to_select_state = POINTINGSTICK_PRESS_TO_SELECT_IDLE;
+        update_press_to_selecting(core);
+        set_button(core, events, &n, 1, core->left_button || core->press_to_selecting);
+    }
+
+    if (prediction_outstanding(core) && (int)(now - core->prediction_expires) >= 0) {
+        core->pending_motion[0] -= core->predicted[0];
+        core->pending_motion[1] -= core->predicted[1];
+        core->motion_pending = 1;
+        core->predicted[0] = 0;
+        core->predicted[1] = 0;
+        core->velocity[0] = 0;
+        core->velocity[1] = 0;
+        core->recent_motion[0] = 0;
+        core->recent_motion[1] = 0;
+    }
+
+    if (core->motion_pending) {
+        flush_motion(core, events, &n);
+        core->motion_posted = now;
+    }
+    return n;
+}
+
+/*
+ * Returns in how many ms pointingstick_core_flush_motion() is due, or -1
+ * if no motion is held back, no prediction is outstanding and no
+ * press-to-select dwell is running.
+ */
+int
+pointingstick_core_motion_delay (PointingStickCore *core, unsigned int now)
+{
+    int delay = -1, expires;
+
+    if (core->motion_pending) {
+        if (core->motion_rate <= 0)
+            return 0;
+        delay = core->motion_posted + 1000u / core->motion_rate - now;
+        if (delay < 0)
+            delay = 0;
+    }
+
+    if (prediction_outstanding(core)) {
+        expires = core->prediction_expires - now;
+        if (expires < 0)
+            expires = 0;
+        if (delay < 0 || expires < delay)
+            delay = expires;
+    }
+
+    if (press_to_select_dwelling(core)) {
+        expires = core->press_to_select_due - now;
+        if (expires < 0)
+            expires = 0;
+        if (delay < 0 || expires < delay)
+            delay = expires;
+    }
+
+    return delay;
+}
+
+/*
+vi:ts=4:nowrap:ai:expandtab:sw=4
+*/
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2010 Hiroyuki Ikezoe
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * The pointing stick processing without any dependency on the X server:
+ * evdev events go in, frame by frame, and the resulting pointer events come
+ * out as an array for the front end (the Xorg module) to post.
+ */
+
+#ifndef _POINTINGSTICK_CORE_H_
+#define _POINTINGSTICK_CORE_H_
+
+#include <linux/input.h>
+
+/* Enough for the worst case frame, see pointingstick_core_process_frame(). */
+#define POINTINGSTICK_MAX_EVENTS 16
+
+typedef enum {
+    POINTINGSTICK_EVENT_MOTION,
+    POINTINGSTICK_EVENT_BUTTON
+} PointingStickEventType;
+
+/* software press-to-select, sticks without TrackPoint firmware */
+typedef enum {
+    POINTINGSTICK_PRESS_TO_SELECT_IDLE,
+    POINTINGSTICK_PRESS_TO_SELECT_PRESSING,  /* above the press threshold */
+    POINTINGSTICK_PRESS_TO_SELECT_SELECTING, /* button 1 is held */
+    POINTINGSTICK_PRESS_TO_SELECT_RELEASING  /* below the release threshold */
+} PointingStickPressToSelectState;
+
+typedef struct _PointingStickEvent
+{
+    PointingStickEventType type;
+    double dx;
+    double dy;
+    int button;
+    int pressed;
+} PointingStickEvent;
+
+typedef struct _PointingStickCore
+{
+    /* configuration */
+    int has_abs_events;
+    int is_trackpoint;
+    int sensitivity;
+    int scrolling;
+    int scroll_distance;
+    int scroll_max_rate;
+    unsigned int middle_button_timeout;
+    int press_to_select;
+    int press_to_select_threshold;
+    int press_to_select_release_threshold;
+    unsigned int press_to_select_dwell;
+    int drift_compensation;
+    int motion_rate;
+    unsigned int latency_budget;
+    int monotonic_time; /* evdev timestamps are on the clock of now */
+    unsigned int prediction_horizon;
+
+    /* the frame being read */
+    unsigned int time; /* of the SYN_REPORT, in ms */
+    int x;
+    int y;
+    int pressure;
+    int button_touched;
+    int touch_released; /* BTN_TOUCH went to 0 in this frame */
+    int left_button;
+    int right_button;
+    int middle_button;
+
+    /* processing state */
+    int middle_button_is_pressed;
+    unsigned int middle_button_click_expires;
+    double scroll_accumulated[2];
+    unsigned int scroll_last_click[2];
+    PointingStickPressToSelectState press_to_select_state;
+    unsigned int press_to_select_since;
+    unsigned int press_to_select_due; /* end of the dwell, on the clock of now */
+    int press_to_selecting;
+    unsigned int posted_buttons;
+    double pending_motion[2];
+    int motion_pending;
+    unsigned int motion_posted;
+    int stale;
+    int folded_frames;
+    int folded_frames_changed;
+    unsigned int last_motion_time;
+    unsigned int prediction_expires;
+    double recent_motion[2]; /* since last_motion_time */
+    double velocity[2];
+    double predicted[2];
+    int drift_frames;
+    unsigned int drift_start; /* of the learning window, evdev time */
+    int drift_sum[2];
+    int drift_min[2];
+    int drift_max[2];
+    unsigned int drift_last_time;
+    int drift_baseline[2]; /* in 1/256 counts per second */
+    int drift_residual[2];
+    int drift_baseline_changed;
+    int last_left_button;
+    int last_right_button;
+    int last_middle_button;
+} PointingStickCore;
+
+void pointingstick_core_init          (PointingStickCore *core,
+                                       int                has_abs_events,
+                                       int                is_trackpoint);
+int  pointingstick_core_handle_event  (PointingStickCore *core,
+                                       const struct input_event *ev);
+int  pointingstick_core_process_frame (PointingStickCore *core,
+                                       unsigned int       now,
+                                       PointingStickEvent *events);
+void pointingstick_core_reset_drift   (PointingStickCore *core);
+int  pointingstick_core_flush_motion  (PointingStickCore *core,
+                                       unsigned int       now,
+                                       PointingStickEvent *events);
+int  pointingstick_core_motion_delay  (PointingStickCore *core,
+                                       unsigned int       now);
+
+#endif
+
+/*
+vi:ts=4:nowrap:ai:expandtab:sw=4
+*/
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2010 Hiroyuki Ikezoe
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pointingstick-telemetry.h"
+
+/*
+ * Creates the segment and maps it read-write.  Readers only need read
+ * access, so the segment is world readable.  A segment left behind under
+ * the name is removed first and never reused: another user could have
+ * created it and could shrink it under the writer, which would then die
+ * of SIGBUS.  If it cannot be removed, telemetry stays off.
+ */
+PointingStickTelemetry *
+pointingstick_telemetry_create (const char *name, const char *device_name)
+{
+    PointingStickTelemetry *telemetry;
+    int fd;
+
+    shm_unlink(name);
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1)
+        return NULL;
+
+    if (ftruncate(fd, sizeof(*telemetry)) == -1) {
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+
+    telemetry = mmap(NULL, sizeof(*telemetry), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+    close(fd);
+    if (telemetry == MAP_FAILED) {
+        shm_unlink(name);
+        return NULL;
+    }
+
+    /* an odd sequence keeps readers off while the segment is reset */
+    telemetry->sequence |= 1;
+    telemetry_write_barrier();
+    memset(telemetry->device_name, 0,
+           sizeof(*telemetry) - offsetof(PointingStickTelemetry, device_name));
+    strncpy(telemetry->device_name, device_name, sizeof(telemetry->device_name) - 1);
+    telemetry->version = POINTINGSTICK_TELEMETRY_VERSION;
+    telemetry->magic = POINTINGSTICK_TELEMETRY_MAGIC;
+    telemetry_write_barrier();
+    telemetry->sequence++;
+
+    return telemetry;
+}
+
+void
+pointingstick_telemetry_destroy (PointingStickTelemetry *telemetry,
+                                 const char             *name)
+{
+    if (!telemetry)
+        return;
+
+    munmap(telemetry, sizeof(*telemetry));
+    shm_unlink(name);
+}
+
+static void
+record_button (PointingStickTelemetry *telemetry, int button, int pressed)
+{
+    unsigned int mask;
+
+    if (button > 3) {
+        if (pressed)
+            telemetry->scroll_events++;
+        return;
+    }
+
+    mask = 1 << (button - 1);
+    if (!!(telemetry->buttons & mask) == !!pressed)
+        return;
+
+    telemetry->buttons ^= mask;
+    telemetry->button_events++;
+}
+
+/*
+ * Called by the writer for every frame handed to
+ * pointingstick_core_process_frame(); x and y are the raw values of the
+ * frame since the core clears relative deltas once it is processed.
+ */
+void
+pointingstick_telemetry_record_frame (PointingStickTelemetry   *telemetry,
+                                      const PointingStickCore  *core,
+                                      unsigned int              now,
+                                      int                       x,
+                                      int                       y,
+                                      const PointingStickEvent *events,
+                                      int                       n)
+{
+    int i;
+
+    pointingstick_telemetry_begin(telemetry);
+
+    telemetry->frames++;
+    if (n == 0)
+        telemetry->suppressed_frames++;
+
+    telemetry->time = now;
+    telemetry->x = x;
+    telemetry->y = y;
+    telemetry->pressure = core->pressure;
+    telemetry->dx = 0;
+    telemetry->dy = 0;
+    telemetry->scrolling = core->scrolling && core->middle_button_is_pressed;
+    telemetry->press_to_selecting = core->press_to_selecting;
+    telemetry->drift_baseline[0] = core->drift_baseline[0];
+    telemetry->drift_baseline[1] = core->drift_baseline[1];
+
+    for (i = 0; i < n; i++) {
+        const PointingStickEvent *event = &events[i];
+
+        switch (event->type) {
+        case POINTINGSTICK_EVENT_MOTION:
+            telemetry->motion_events++;
+            telemetry->dx = event->dx;
+            telemetry->dy = event->dy;
+            break;
+        case POINTINGSTICK_EVENT_BUTTON:
+            record_button(telemetry, event->button, event->pressed);
+            break;
+        }
+    }
+
+    pointingstick_telemetry_end(telemetry);
+}
+
+const PointingStickTelemetry *
+pointingstick_telemetry_attach (const char *name)
+{
+    PointingStickTelemetry *telemetry;
+    struct stat st;
+    int fd;
+
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1)
+        return NULL;
+
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(*telemetry)) {
+        close(fd);
+        return NULL;
+    }
+
+    telemetry = mmap(NULL, sizeof(*telemetry), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (telemetry == MAP_FAILED)
+        return NULL;
+
+    return telemetry;
+}
+
+void
+pointingstick_telemetry_detach (const PointingStickTelemetry *telemetry)
+{
+    if (telemetry)
+        munmap((void *)telemetry, sizeof(*telemetry));
+}
+
+#define SNAPSHOT_ATTEMPTS 1000
+
+/*
+ * Copies a consistent view of the segment.  Returns 0 on success, -1 if the
+ * segment is not one written by a compatible driver, or stays locked (the
+ * writer died in the middle of an update).
+ */
+int
+pointingstick_telemetry_snapshot (const PointingStickTelemetry *telemetry,
+                                  PointingStickTelemetry       *snapshot)
+{
+    unsigned int begin, end;
+    int attempts = SNAPSHOT_ATTEMPTS;
+
+    do {
+        if (attempts-- == 0)
+            return -1;
+        begin = telemetry->sequence;
+        telemetry_read_barrier();
+        memcpy(snapshot, (const void *)telemetry, sizeof(*snapshot));
+        telemetry_read_barrier();
+        end = telemetry->sequence;
+    } while ((begin & 1) || begin != end);
+
+    if (snapshot->magic != POINTINGSTICK_TELEMETRY_MAGIC ||
+        snapshot->version != POINTINGSTICK_TELEMETRY_VERSION)
+        return -1;
+
+    return 0;
+}
+
+/*
+vi:ts=4:nowrap:ai:expandtab:sw=4
+*/
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2010 Hiroyuki Ikezoe
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Live counters and the latest frame, published in a POSIX shared memory
+ * segment for tools/pointingstick-top.  The driver side is a handful of
+ * plain stores per frame; consistency is provided by a sequence lock: the
+ * writer makes the sequence odd while it updates the segment and readers
+ * retry until they copied it between two reads of the same even sequence.
+ * There is a single writer per segment.
+ */
+
+#ifndef _POINTINGSTICK_TELEMETRY_H_
+#define _POINTINGSTICK_TELEMETRY_H_
+
+#include "pointingstick-core.h"
+
+#define POINTINGSTICK_TELEMETRY_MAGIC 0x50535431 /* "PST1" */
+#define POINTINGSTICK_TELEMETRY_VERSION 2
+#define POINTINGSTICK_TELEMETRY_DEFAULT_NAME "/pointingstick"
+
+typedef struct _PointingStickTelemetry
+{
+    unsigned int magic;
+    unsigned int version;
+    volatile unsigned int sequence;
+    char device_name[64];
+
+    /* counters */
+    unsigned int frames;
+    unsigned int suppressed_frames; /* with nothing to post */
+    unsigned int motion_events;
+    unsigned int button_events;
+    unsigned int scroll_events;
+    unsigned int read_errors;
+
+    /* the latest frame */
+    unsigned int time;
+    int x;
+    int y;
+    int pressure;
+    double dx;
+    double dy;
+    unsigned int buttons; /* bit 0 left, bit 1 middle, bit 2 right */
+    int scrolling;
+    int press_to_selecting;
+    int drift_baseline[2];
+
+    /* report rate programmed by the driver, 0 if left alone */
+    int report_rate;
+} PointingStickTelemetry;
+
+/*
+ * On x86 a release/acquire fence is only a compiler barrier, so the writer
+ * really costs plain stores there.
+ */
+#if defined(__ATOMIC_RELEASE)
+#define telemetry_write_barrier() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define telemetry_read_barrier() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#else
+#define telemetry_write_barrier() __sync_synchronize()
+#define telemetry_read_barrier() __sync_synchronize()
+#endif
+
+static inline void
+pointingstick_telemetry_begin (PointingStickTelemetry *telemetry)
+{
+    telemetry->sequence++;
+    telemetry_write_barrier();
+}
+
+static inline void
+pointingstick_telemetry_end (PointingStickTelemetry *telemetry)
+{
+    telemetry_write_barrier();
+    telemetry->sequence++;
+}
+
+PointingStickTelemetry *pointingstick_telemetry_create  (const char *name,
+                                                         const char *device_name);
+void pointingstick_telemetry_destroy (PointingStickTelemetry *telemetry,
+                                      const char             *name);
+void pointingstick_telemetry_record_frame (PointingStickTelemetry   *telemetry,
+                                           const PointingStickCore  *core,
+                                           unsigned int              now,
+                                           int                       x,
+                                           int                       y,
+                                           const PointingStickEvent *events,
+                                           int                       n);
+
+const PointingStickTelemetry *pointingstick_telemetry_attach (const char *name);
+void pointingstick_telemetry_detach   (const PointingStickTelemetry *telemetry);
+int  pointingstick_telemetry_snapshot (const PointingStickTelemetry *telemetry,
+                                       PointingStickTelemetry       *snapshot);
+
+#endif
+
+/*
+vi:ts=4:nowrap:ai:expandtab:sw=4
+*/
@@ -33,6 +33,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <dirent.h>
+#include <time.h>
 
 #include <xf86_OSproc.h>
 #include <xf86.h>
@@ -44,21 +45,42 @@
 static Atom prop_sensitivity = 0;
 static Atom prop_speed = 0;
 static Atom prop_scrolling = 0;
+static Atom prop_scroll_distance = 0;
+static Atom prop_scroll_max_rate = 0;
+static Atom prop_motion_rate = 0;
 static Atom prop_middle_button_timeout = 0;
 static Atom prop_press_to_select = 0;
 static Atom prop_press_to_select_threshold = 0;
+static Atom prop_press_to_select_release_threshold = 0;
+static Atom prop_press_to_select_dwell = 0;
+static Atom prop_drift_compensation = 0;
+static Atom prop_drift_baseline = 0;
+static Atom prop_adaptive_rate = 0;
+static Atom prop_report_rate = 0;
+static Atom prop_report_rate_idle_timeout = 0;
+static Atom prop_resolution = 0;
+static Atom prop_read_errors = 0;
+static Atom prop_latency_budget = 0;
+static Atom prop_folded_frames = 0;
+static Atom prop_prediction_horizon = 0;
 
 #if GET_ABI_MAJOR(ABI_XINPUT_VERSION) >= 7
 #include <xserver-properties.h>
+#include <ptrveloc.h>
 #endif
 
+#include "pointingstick-core.h"
+#include "pointingstick-telemetry.h"
 #include "pointingstick.h"
 #include "pointingstick-properties.h"
+#include "probes.h"
 #include "trackpoint.h"
+#include "trackpoint-sysfs.h"
 
 #define LONG_BITS (sizeof(long) * 8)
 #define NLONGS(x) (((x) + LONG_BITS - 1) / LONG_BITS)
 #define TestBit(bit, array) ((array[(bit) / LONG_BITS]) & (1L << ((bit) % LONG_BITS)))
+#define SetBit(bit, array) ((array[(bit) / LONG_BITS]) |= (1L << ((bit) % LONG_BITS)))
 #define SYSCALL(call) while (((call) == -1) && (errno == EINTR))
 
 static int          pre_init       (InputDriverPtr drv,
@@ -125,6 +147,7 @@ static Bool
 is_pointingstick (InputInfoPtr local)
 {
     int rc;
+    Bool has_abs_events;
     unsigned long evbits[NLONGS(EV_MAX)] = {0};
     PointingStickPrivate *priv = local->private;
 
@@ -147,7 +170,7 @@ is_pointingstick (InputInfoPtr local)
             !TestBit(ABS_PRESSURE, absbits)) {
             return FALSE;
         }
-        priv->has_abs_events = TRUE;
+        has_abs_events = TRUE;
     } else if (TestBit(EV_REL, evbits)) {
         unsigned long relbits[NLONGS(REL_MAX)] = {0};
         SYSCALL(rc = ioctl(local->fd, EVIOCGBIT(EV_REL, sizeof(relbits)), relbits));
@@ -158,17 +181,20 @@ is_pointingstick (InputInfoPtr local)
             !TestBit(REL_Y, relbits)) {
             return FALSE;
         }
-        priv->has_abs_events = FALSE;
-        priv->pressure = 1;
+        has_abs_events = FALSE;
     } else {
         return FALSE;
     }
 
-    priv->is_trackpoint = pointingstick_is_trackpoint(local);
+    pointingstick_core_init(&priv->core, has_abs_events,
+                            pointingstick_is_trackpoint(local));
 
     return TRUE;
 }
 
+#define READ_ERROR_BURST 5
+#define READ_ERROR_REFILL_INTERVAL 10000
+
 static void
 set_default_values (InputInfoPtr local)
 {
@@ -178,34 +204,67 @@ set_default_values (InputInfoPtr local)
     Bool press_to_select;
 
     priv->trackpoint_sysfs_path = NULL;
+    priv->sysfs_watch_fd = -1;
+    priv->sysfs_watch_handler = NULL;
 
-    if (priv->is_trackpoint) {
+    if (priv->core.is_trackpoint) {
         sensitivity = trackpoint_get_sensitivity(local);
         speed = trackpoint_get_speed(local);
         press_to_select = trackpoint_get_press_to_select(local);
         press_to_select_threshold = trackpoint_get_press_to_select_threshold(local);
     } else {
-        if (priv->has_abs_events)
-            sensitivity = 100;
-        else
-            sensitivity = 255;
-        press_to_select = FALSE;
-        press_to_select_threshold = 8;
+        sensitivity = priv->core.sensitivity;
+        press_to_select = priv->core.press_to_select;
+        press_to_select_threshold = priv->core.press_to_select_threshold;
     }
 
-    priv->sensitivity = xf86SetIntOption(local->options, "Sensitivity", sensitivity);
+    priv->core.sensitivity = xf86SetIntOption(local->options, "Sensitivity", sensitivity);
     if (speed > 0)
         priv->speed = xf86SetIntOption(local->options, "Speed", speed);
-    priv->middle_button_timeout = xf86SetIntOption(local->options, "MiddleButtonTimeout", 100);
-    priv->press_to_select = xf86SetBoolOption(local->options, "PressToSelect", press_to_select);
-    priv->press_to_select_threshold = xf86SetIntOption(local->options,
-                                                       "PressToSelectThreshold",
-                                                       press_to_select_threshold);
-
-    priv->scrolling = TRUE;
-    priv->middle_button_is_pressed = FALSE;
-    priv->press_to_selecting = FALSE;
-    priv->button_touched = FALSE;
+    priv->core.middle_button_timeout = xf86SetIntOption(local->options, "MiddleButtonTimeout",
+                                                        priv->core.middle_button_timeout);
+    priv->core.scroll_distance = xf86SetIntOption(local->options, "ScrollDistance",
+                                                  priv->core.scroll_distance);
+    if (priv->core.scroll_distance < 1)
+        priv->core.scroll_distance = 1;
+    priv->core.scroll_max_rate = xf86SetIntOption(local->options, "ScrollMaxRate",
+                                                  priv->core.scroll_max_rate);
+    if (priv->core.scroll_max_rate < 0)
+        priv->core.scroll_max_rate = 0;
+    priv->core.motion_rate = xf86SetIntOption(local->options, "MotionRate", 0);
+    if (priv->core.motion_rate < 0)
+        priv->core.motion_rate = 0;
+    priv->core.latency_budget = xf86SetIntOption(local->options, "LatencyBudget", 0);
+    if ((int)priv->core.latency_budget < 0)
+        priv->core.latency_budget = 0;
+    priv->core.prediction_horizon = xf86SetIntOption(local->options, "PredictionHorizon", 0);
+    if ((int)priv->core.prediction_horizon < 0)
+        priv->core.prediction_horizon = 0;
+    priv->core.press_to_select = xf86SetBoolOption(local->options, "PressToSelect", press_to_select);
+    priv->core.press_to_select_threshold = xf86SetIntOption(local->options,
+                                                            "PressToSelectThreshold",
+                                                            press_to_select_threshold);
+    priv->core.press_to_select_release_threshold =
+        xf86SetIntOption(local->options, "PressToSelectReleaseThreshold",
+                         priv->core.press_to_select_threshold * 3 / 4);
+    priv->core.press_to_select_dwell = xf86SetIntOption(local->options, "PressToSelectDwell",
+                                                        priv->core.press_to_select_dwell);
+    priv->exclusive_grab = xf86SetBoolOption(local->options, "ExclusiveGrab", FALSE);
+    priv->core.drift_compensation = xf86SetBoolOption(local->options,
+                                                      "DriftCompensation", FALSE);
+    priv->adaptive_rate = xf86SetBoolOption(local->options, "AdaptiveRate", FALSE);
+    priv->idle_rate = xf86SetIntOption(local->options, "IdleRate", 100);
+    priv->active_rate = xf86SetIntOption(local->options, "ActiveRate", 200);
+    priv->rate_idle_timeout = xf86SetIntOption(local->options, "RateIdleTimeout", 1000);
+    priv->resolution = xf86SetIntOption(local->options, "Resolution", 0);
+    priv->telemetry_name = xf86SetStrOption(local->options, "Telemetry", NULL);
+    /* an explicitly configured server profile wins */
+    priv->accel_profile = xf86SetBoolOption(local->options, "AccelProfile",
+                                            !xf86FindOptionValue(local->options,
+                                                                 "AccelerationProfile"));
+
+    priv->read_error_tokens = READ_ERROR_BURST;
+    priv->read_error_refilled = GetTimeInMillis();
 }
 
 static int
@@ -214,6 +273,7 @@ pre_init(InputDriverPtr  drv,
          int             flags)
 {
     PointingStickPrivate *priv;
+    const char *sysfs_root;
 
     priv = calloc(1, sizeof(PointingStickPrivate));
     if (!priv)
@@ -231,6 +291,10 @@ pre_init(InputDriverPtr  drv,
     if (info->fd == -1)
         goto end;
 
+    sysfs_root = getenv(TRACKPOINT_SYSFS_ROOT_ENV);
+    priv->sysfs_root = xf86SetStrOption(info->options, "SysfsRoot",
+                                        sysfs_root ? sysfs_root : TRACKPOINT_SYSFS_ROOT);
+
     if (!is_pointingstick(info))
         goto end;
 
@@ -246,6 +310,10 @@ pre_init(InputDriverPtr  drv,
         info->fd = -1;
     }
 
+    if (priv) {
+        free(priv->sysfs_root);
+        free(priv->telemetry_name);
+    }
     free(priv);
     info->private = NULL;
 
@@ -257,6 +325,12 @@ uninit (InputDriverPtr drv,
         InputInfoPtr   local,
         int            flags)
 {
+    PointingStickPrivate *priv = local->private;
+
+    if (priv) {
+        free(priv->sysfs_root);
+        free(priv->telemetry_name);
+    }
     free(local->private);
     local->private = NULL;
     xf86DeleteInput(local, 0);
@@ -267,6 +341,121 @@ pointingstick_control (DeviceIntPtr device, PtrCtrl *ctrl)
 {
 }
 
+#define MAX_PROPERTY_VALUES 4
+
+static void
+update_property (DeviceIntPtr device,
+                 Atom atom,
+                 int format,
+                 int nvalues,
+                 const int *values)
+{
+    InputInfoPtr local = device->public.devicePrivate;
+    PointingStickPrivate *priv = local->private;
+    CARD8 values8[MAX_PROPERTY_VALUES];
+    CARD16 values16[MAX_PROPERTY_VALUES];
+    CARD32 values32[MAX_PROPERTY_VALUES];
+    pointer data;
+    int i;
+
+    if (!atom || nvalues > MAX_PROPERTY_VALUES)
+        return;
+
+    for (i = 0; i < nvalues; i++) {
+        values8[i] = values[i];
+        values16[i] = values[i];
+        values32[i] = values[i];
+    }
+
+    switch (format) {
+    case 8:
+        data = values8;
+        break;
+    case 16:
+        data = values16;
+        break;
+    default:
+        data = values32;
+        break;
+    }
+
+    priv->updating_properties = TRUE;
+    XIChangeDeviceProperty(device, atom, XA_INTEGER, format,
+                           PropModeReplace, nvalues, data, TRUE);
+    priv->updating_properties = FALSE;
+}
+
+/*
+ * Properties must not be changed from read_input(), which may run in a
+ * signal handler, so the input path only flags changes and arms this timer.
+ */
+static CARD32
+publish_properties (OsTimerPtr timer, CARD32 now, pointer arg)
+{
+    InputInfoPtr local = arg;
+    PointingStickPrivate *priv = local->private;
+
+    if (priv->core.drift_baseline_changed) {
+        priv->core.drift_baseline_changed = FALSE;
+        update_property(local->dev, prop_drift_baseline, 32, 2,
+                        priv->core.drift_baseline);
+    }
+    if (priv->read_errors_changed) {
+        priv->read_errors_changed = FALSE;
+        update_property(local->dev, prop_read_errors, 32, 1,
+                        &priv->read_errors);
+    }
+    if (priv->core.folded_frames_changed) {
+        priv->core.folded_frames_changed = FALSE;
+        update_property(local->dev, prop_folded_frames, 32, 1,
+                        &priv->core.folded_frames);
+    }
+
+    return 0;
+}
+
+static void
+schedule_property_update (InputInfoPtr local)
+{
+    PointingStickPrivate *priv = local->private;
+
+    priv->property_timer = TimerSet(priv->property_timer, 0, 1,
+                                    publish_properties, local);
+}
+
+#define MIN_REPORT_RATE 10
+#define MAX_REPORT_RATE 200
+
+/*
+ * Report rate changes are rare and come from the main loop, so the
+ * telemetry update is protected against read_input() by blocking SIGIO.
+ */
+static void
+set_report_rate (InputInfoPtr local, int rate)
+{
+    PointingStickPrivate *priv = local->private;
+    int sigstate;
+
+    if (trackpoint_set_rate(local, rate) != Success || !priv->telemetry)
+        return;
+
+    sigstate = xf86BlockSIGIO();
+    pointingstick_telemetry_begin(priv->telemetry);
+    priv->telemetry->report_rate = rate;
+    pointingstick_telemetry_end(priv->telemetry);
+    xf86UnblockSIGIO(sigstate);
+}
+
+/* Puts back the rate the stick had before AdaptiveRate changed it. */
+static void
+restore_report_rate (InputInfoPtr local)
+{
+    PointingStickPrivate *priv = local->private;
+
+    if (priv->saved_rate >= MIN_REPORT_RATE && priv->saved_rate <= MAX_REPORT_RATE)
+        set_report_rate(local, priv->saved_rate);
+}
+
 static int
 set_property(DeviceIntPtr device,
              Atom atom,
@@ -287,13 +476,13 @@ set_property(DeviceIntPtr device,
             return BadValue;
 
         if (!checkonly) {
-            if (priv->is_trackpoint)
+            if (priv->core.is_trackpoint && !priv->updating_properties)
                 trackpoint_set_sensitivity(local, sensitivity);
-            priv->sensitivity = sensitivity;
+            priv->core.sensitivity = sensitivity;
         }
     }
 
-    if (priv->is_trackpoint && atom == prop_speed) {
+    if (priv->core.is_trackpoint && atom == prop_speed) {
         int speed;
 
         if (val->format != 8 || val->size != 1 || val->type != XA_INTEGER)
@@ -304,7 +493,7 @@ set_property(DeviceIntPtr device,
             return BadValue;
 
         if (!checkonly) {
-            if (priv->is_trackpoint)
+            if (priv->core.is_trackpoint && !priv->updating_properties)
                 trackpoint_set_speed(local, speed);
             priv->speed = speed;
         }
@@ -315,7 +504,53 @@ set_property(DeviceIntPtr device,
             return BadMatch;
 
         if (!checkonly)
-            priv->scrolling = *((BOOL*)val->data);
+            priv->core.scrolling = *((BOOL*)val->data);
+    }
+
+    if (atom == prop_scroll_distance) {
+        int distance;
+
+        if (val->format != 16 || val->size != 1 || val->type != XA_INTEGER)
+            return BadMatch;
+
+        distance = *((CARD16*)val->data);
+        if (distance < 1)
+            return BadValue;
+
+        if (!checkonly)
+            priv->core.scroll_distance = distance;
+    }
+
+    if (atom == prop_scroll_max_rate) {
+        if (val->format != 16 || val->size != 1 || val->type != XA_INTEGER)
+            return BadMatch;
+
+        if (!checkonly)
+            priv->core.scroll_max_rate = *((CARD16*)val->data);
+    }
+
+    if (atom == prop_motion_rate) {
+        if (val->format != 16 || val->size != 1 || val->type != XA_INTEGER)
+            return BadMatch;
+
+        if (!checkonly)
+            priv->core.motion_rate = *((CARD16*)val->data);
+    }
+
+    if (atom == prop_latency_budget) {
+        if (val->format != 16 || val->size != 1 || val->type != XA_INTEGER)
+            return BadMatch;
+
+        if (!checkonly)
+            priv->core.latency_budget = *((CARD16*)val->data);
+    }
+
+    if (atom == prop_prediction_horizon) {
+        if (val->format != 16 || val->size != 1 || val->type != XA_INTEGER)
+            return BadMatch;
+
+        if (!checkonly)
+            priv->core.prediction_horizon = *((CARD16*)val->data);
     }
 
     if (atom == prop_middle_button_timeout) {
@@ -329,7 +564,7 @@ set_property(DeviceIntPtr device,
             return BadValue;
 
         if (!checkonly)
-            priv->middle_button_timeout = timeout;
+            priv->core.middle_button_timeout = timeout;
     }
 
     if (atom == prop_press_to_select) {
@@ -337,9 +572,9 @@ set_property(DeviceIntPtr device,
             return BadMatch;
 
         if (!checkonly) {
-            if (priv->is_trackpoint)
+            if (priv->core.is_trackpoint && !priv->updating_properties)
                 trackpoint_set_press_to_select(local, *((BOOL*)val->data));
-            priv->press_to_select = *((BOOL*)val->data);
+            priv->core.press_to_select = *((BOOL*)val->data);
         }
     }
 
@@ -354,12 +589,113 @@ set_property(DeviceIntPtr device,
             return BadValue;
 
         if (!checkonly) {
-            if (priv->is_trackpoint)
+            if (priv->core.is_trackpoint && !priv->updating_properties)
                 trackpoint_set_press_to_select_threshold(local, threshold);
-            priv->press_to_select_threshold = threshold;
+            priv->core.press_to_select_threshold = threshold;
+        }
+    }
+
+    if (!priv->core.is_trackpoint && atom == prop_press_to_select_release_threshold) {
+        int threshold;
+
+        if (val->format != 8 || val->size != 1 || val->type != XA_INTEGER)
+            return BadMatch;
+
+        threshold = *((CARD8*)val->data);
+        if (threshold > 127)
+            return BadValue;
+
+        if (!checkonly)
+            priv->core.press_to_select_release_threshold = threshold;
+    }
+
+    if (!priv->core.is_trackpoint && atom == prop_press_to_select_dwell) {
+        if (val->format != 16 || val->size != 1 || val->type != XA_INTEGER)
+            return BadMatch;
+
+        if (!checkonly)
+            priv->core.press_to_select_dwell = *((CARD16*)val->data);
+    }
+
+    if (atom == prop_drift_compensation) {
+        if (val->format != 8 || val->size != 1 || val->type != XA_INTEGER)
+            return BadMatch;
+
+        if (!checkonly) {
+            priv->core.drift_compensation = *((BOOL*)val->data);
+            pointingstick_core_reset_drift(&priv->core);
+            schedule_property_update(local);
+        }
+    }
+
+    if (priv->core.is_trackpoint && atom == prop_adaptive_rate) {
+        if (val->format != 8 || val->size != 1 || val->type != XA_INTEGER)
+            return BadMatch;
+
+        if (!checkonly) {
+            priv->adaptive_rate = *((BOOL*)val->data);
+            if (priv->adaptive_rate)
+                set_report_rate(local, priv->idle_rate);
+            else
+                restore_report_rate(local);
+            priv->rate_active = FALSE;
+            priv->rate_active_frames = 0;
+            priv->rate_switched = GetTimeInMillis();
+        }
+    }
+
+    if (priv->core.is_trackpoint && atom == prop_report_rate) {
+        CARD8 *rates;
+
+        if (val->format != 8 || val->size != 2 || val->type != XA_INTEGER)
+            return BadMatch;
+
+        rates = (CARD8*)val->data;
+        if (rates[0] < MIN_REPORT_RATE || rates[0] > MAX_REPORT_RATE ||
+            rates[1] < MIN_REPORT_RATE || rates[1] > MAX_REPORT_RATE)
+            return BadValue;
+
+        if (!checkonly) {
+            priv->idle_rate = rates[0];
+            priv->active_rate = rates[1];
+            if (priv->adaptive_rate)
+                set_report_rate(local, priv->rate_active ?
+                                       priv->active_rate : priv->idle_rate);
+        }
+    }
+
+    if (priv->core.is_trackpoint && atom == prop_report_rate_idle_timeout) {
+        if (val->format != 16 || val->size != 1 || val->type != XA_INTEGER)
+            return BadMatch;
+
+        if (!checkonly)
+            priv->rate_idle_timeout = *((CARD16*)val->data);
+    }
+
+    if (priv->core.is_trackpoint && atom == prop_resolution) {
+        int resolution;
+
+        if (val->format != 8 || val->size != 1 || val->type != XA_INTEGER)
+            return BadMatch;
+
+        resolution = *((CARD8*)val->data);
+        if (resolution > 200)
+            return BadValue;
+
+        if (!checkonly) {
+            if (resolution > 0)
+                trackpoint_set_resolution(local, resolution);
+            priv->resolution = resolution;
         }
     }
 
+    if (atom == prop_drift_baseline || atom == prop_read_errors ||
+        atom == prop_folded_frames) {
+        /* read-only */
+        if (!priv->updating_properties)
+            return BadAccess;
+    }
+
     return Success;
 }
 
@@ -374,13 +710,13 @@ init_properties (DeviceIntPtr device)
                                 strlen(POINTINGSTICK_PROP_SENSITIVITY), TRUE);
     rc = XIChangeDeviceProperty(device, prop_sensitivity, XA_INTEGER, 8,
                                 PropModeReplace, 1,
-                                &priv->sensitivity,
+                                &priv->core.sensitivity,
                                 FALSE);
     if (rc != Success)
         return;
     XISetDevicePropertyDeletable(device, prop_sensitivity, FALSE);
 
-    if (priv->is_trackpoint) {
+    if (priv->core.is_trackpoint) {
         prop_speed = MakeAtom(POINTINGSTICK_PROP_SPEED,
                               strlen(POINTINGSTICK_PROP_SPEED), TRUE);
         rc = XIChangeDeviceProperty(device, prop_speed, XA_INTEGER, 8,
@@ -396,18 +732,48 @@ init_properties (DeviceIntPtr device)
                               strlen(POINTINGSTICK_PROP_SCROLLING), TRUE);
     rc = XIChangeDeviceProperty(device, prop_scrolling, XA_INTEGER, 8,
                                 PropModeReplace, 1,
-                                &priv->scrolling,
+                                &priv->core.scrolling,
                                 FALSE);
     if (rc != Success)
         return;
     XISetDevicePropertyDeletable(device, prop_scrolling, FALSE);
 
+    prop_scroll_distance = MakeAtom(POINTINGSTICK_PROP_SCROLL_DISTANCE,
+                                    strlen(POINTINGSTICK_PROP_SCROLL_DISTANCE), TRUE);
+    rc = XIChangeDeviceProperty(device, prop_scroll_distance, XA_INTEGER, 16,
+                                PropModeReplace, 1,
+                                &priv->core.scroll_distance,
+                                FALSE);
+    if (rc != Success)
+        return;
+    XISetDevicePropertyDeletable(device, prop_scroll_distance, FALSE);
+
+    prop_scroll_max_rate = MakeAtom(POINTINGSTICK_PROP_SCROLL_MAX_RATE,
+                                    strlen(POINTINGSTICK_PROP_SCROLL_MAX_RATE), TRUE);
+    rc = XIChangeDeviceProperty(device, prop_scroll_max_rate, XA_INTEGER, 16,
+                                PropModeReplace, 1,
+                                &priv->core.scroll_max_rate,
+                                FALSE);
+    if (rc != Success)
+        return;
+    XISetDevicePropertyDeletable(device, prop_scroll_max_rate, FALSE);
+
+    prop_motion_rate = MakeAtom(POINTINGSTICK_PROP_MOTION_RATE,
+                                strlen(POINTINGSTICK_PROP_MOTION_RATE), TRUE);
+    rc = XIChangeDeviceProperty(device, prop_motion_rate, XA_INTEGER, 16,
+                                PropModeReplace, 1,
+                                &priv->core.motion_rate,
+                                FALSE);
+    if (rc != Success)
+        return;
+    XISetDevicePropertyDeletable(device, prop_motion_rate, FALSE);
+
     prop_middle_button_timeout = MakeAtom(POINTINGSTICK_PROP_MIDDLE_BUTTON_TIMEOUT,
                                           strlen(POINTINGSTICK_PROP_MIDDLE_BUTTON_TIMEOUT),
                                           TRUE);
     rc = XIChangeDeviceProperty(device, prop_middle_button_timeout, XA_INTEGER, 16,
                                 PropModeReplace, 1,
-                                &priv->middle_button_timeout,
+                                &priv->core.middle_button_timeout,
                                 FALSE);
     if (rc != Success)
         return;
@@ -417,7 +783,7 @@ init_properties (DeviceIntPtr device)
                                     strlen(POINTINGSTICK_PROP_PRESS_TO_SELECT), TRUE);
     rc = XIChangeDeviceProperty(device, prop_press_to_select, XA_INTEGER, 8,
                                 PropModeReplace, 1,
-                                &priv->press_to_select,
+                                &priv->core.press_to_select,
                                 FALSE);
     if (rc != Success)
         return;
@@ -429,20 +795,301 @@ init_properties (DeviceIntPtr device)
     rc = XIChangeDeviceProperty(device, prop_press_to_select_threshold,
                                 XA_INTEGER, 8,
                                 PropModeReplace, 1,
-                                &priv->press_to_select_threshold,
+                                &priv->core.press_to_select_threshold,
                                 FALSE);
     if (rc != Success)
         return;
     XISetDevicePropertyDeletable(device, prop_press_to_select_threshold, FALSE);
 
+    if (!priv->core.is_trackpoint) {
+        prop_press_to_select_release_threshold =
+            MakeAtom(POINTINGSTICK_PROP_PRESS_TO_SELECT_RELEASE_THRESHOLD,
+                     strlen(POINTINGSTICK_PROP_PRESS_TO_SELECT_RELEASE_THRESHOLD),
+                     TRUE);
+        rc = XIChangeDeviceProperty(device, prop_press_to_select_release_threshold,
+                                    XA_INTEGER, 8,
+                                    PropModeReplace, 1,
+                                    &priv->core.press_to_select_release_threshold,
+                                    FALSE);
+        if (rc != Success)
+            return;
+        XISetDevicePropertyDeletable(device, prop_press_to_select_release_threshold, FALSE);
+
+        prop_press_to_select_dwell = MakeAtom(POINTINGSTICK_PROP_PRESS_TO_SELECT_DWELL,
+                                              strlen(POINTINGSTICK_PROP_PRESS_TO_SELECT_DWELL),
+                                              TRUE);
+        rc = XIChangeDeviceProperty(device, prop_press_to_select_dwell,
+                                    XA_INTEGER, 16,
+                                    PropModeReplace, 1,
+                                    &priv->core.press_to_select_dwell,
+                                    FALSE);
+        if (rc != Success)
+            return;
+        XISetDevicePropertyDeletable(device, prop_press_to_select_dwell, FALSE);
+    }
+
+    if (!priv->core.has_abs_events) {
+        prop_drift_compensation = MakeAtom(POINTINGSTICK_PROP_DRIFT_COMPENSATION,
+                                           strlen(POINTINGSTICK_PROP_DRIFT_COMPENSATION),
+                                           TRUE);
+        rc = XIChangeDeviceProperty(device, prop_drift_compensation,
+                                    XA_INTEGER, 8,
+                                    PropModeReplace, 1,
+                                    &priv->core.drift_compensation,
+                                    FALSE);
+        if (rc != Success)
+            return;
+        XISetDevicePropertyDeletable(device, prop_drift_compensation, FALSE);
+
+        prop_drift_baseline = MakeAtom(POINTINGSTICK_PROP_DRIFT_BASELINE,
+                                       strlen(POINTINGSTICK_PROP_DRIFT_BASELINE),
+                                       TRUE);
+        rc = XIChangeDeviceProperty(device, prop_drift_baseline,
+                                    XA_INTEGER, 32,
+                                    PropModeReplace, 2,
+                                    priv->core.drift_baseline,
+                                    FALSE);
+        if (rc != Success)
+            return;
+        XISetDevicePropertyDeletable(device, prop_drift_baseline, FALSE);
+    }
+
+    if (priv->core.is_trackpoint) {
+        CARD8 rates[2];
+
+        prop_adaptive_rate = MakeAtom(POINTINGSTICK_PROP_ADAPTIVE_RATE,
+                                      strlen(POINTINGSTICK_PROP_ADAPTIVE_RATE),
+                                      TRUE);
+        rc = XIChangeDeviceProperty(device, prop_adaptive_rate, XA_INTEGER, 8,
+                                    PropModeReplace, 1,
+                                    &priv->adaptive_rate,
+                                    FALSE);
+        if (rc != Success)
+            return;
+        XISetDevicePropertyDeletable(device, prop_adaptive_rate, FALSE);
+
+        rates[0] = priv->idle_rate;
+        rates[1] = priv->active_rate;
+        prop_report_rate = MakeAtom(POINTINGSTICK_PROP_REPORT_RATE,
+                                    strlen(POINTINGSTICK_PROP_REPORT_RATE),
+                                    TRUE);
+        rc = XIChangeDeviceProperty(device, prop_report_rate, XA_INTEGER, 8,
+                                    PropModeReplace, 2,
+                                    rates,
+                                    FALSE);
+        if (rc != Success)
+            return;
+        XISetDevicePropertyDeletable(device, prop_report_rate, FALSE);
+
+        prop_report_rate_idle_timeout = MakeAtom(POINTINGSTICK_PROP_REPORT_RATE_IDLE_TIMEOUT,
+                                                 strlen(POINTINGSTICK_PROP_REPORT_RATE_IDLE_TIMEOUT),
+                                                 TRUE);
+        rc = XIChangeDeviceProperty(device, prop_report_rate_idle_timeout,
+                                    XA_INTEGER, 16,
+                                    PropModeReplace, 1,
+                                    &priv->rate_idle_timeout,
+                                    FALSE);
+        if (rc != Success)
+            return;
+        XISetDevicePropertyDeletable(device, prop_report_rate_idle_timeout, FALSE);
+
+        prop_resolution = MakeAtom(POINTINGSTICK_PROP_RESOLUTION,
+                                   strlen(POINTINGSTICK_PROP_RESOLUTION),
+                                   TRUE);
+        rc = XIChangeDeviceProperty(device, prop_resolution, XA_INTEGER, 8,
+                                    PropModeReplace, 1,
+                                    &priv->resolution,
+                                    FALSE);
+        if (rc != Success)
+            return;
+        XISetDevicePropertyDeletable(device, prop_resolution, FALSE);
+    }
+
+    prop_read_errors = MakeAtom(POINTINGSTICK_PROP_READ_ERRORS,
+                                strlen(POINTINGSTICK_PROP_READ_ERRORS), TRUE);
+    rc = XIChangeDeviceProperty(device, prop_read_errors, XA_INTEGER, 32,
+                                PropModeReplace, 1,
+                                &priv->read_errors,
+                                FALSE);
+    if (rc != Success)
+        return;
+    XISetDevicePropertyDeletable(device, prop_read_errors, FALSE);
+
+    prop_latency_budget = MakeAtom(POINTINGSTICK_PROP_LATENCY_BUDGET,
+                                   strlen(POINTINGSTICK_PROP_LATENCY_BUDGET), TRUE);
+    rc = XIChangeDeviceProperty(device, prop_latency_budget, XA_INTEGER, 16,
+                                PropModeReplace, 1,
+                                &priv->core.latency_budget,
+                                FALSE);
+    if (rc != Success)
+        return;
+    XISetDevicePropertyDeletable(device, prop_latency_budget, FALSE);
+
+    prop_folded_frames = MakeAtom(POINTINGSTICK_PROP_FOLDED_FRAMES,
+                                  strlen(POINTINGSTICK_PROP_FOLDED_FRAMES), TRUE);
+    rc = XIChangeDeviceProperty(device, prop_folded_frames, XA_INTEGER, 32,
+                                PropModeReplace, 1,
+                                &priv->core.folded_frames,
+                                FALSE);
+    if (rc != Success)
+        return;
+    XISetDevicePropertyDeletable(device, prop_folded_frames, FALSE);
+
+    prop_prediction_horizon = MakeAtom(POINTINGSTICK_PROP_PREDICTION_HORIZON,
+                                       strlen(POINTINGSTICK_PROP_PREDICTION_HORIZON), TRUE);
+    rc = XIChangeDeviceProperty(device, prop_prediction_horizon, XA_INTEGER, 16,
+                                PropModeReplace, 1,
+                                &priv->core.prediction_horizon,
+                                FALSE);
+    if (rc != Success)
+        return;
+    XISetDevicePropertyDeletable(device, prop_prediction_horizon, FALSE);
+
     XIRegisterPropertyHandler(device, set_property, NULL, NULL);
 }
 
+static void
+sync_trackpoint_settings (int fd, pointer data)
+{
+    InputInfoPtr local = data;
+    PointingStickPrivate *priv = local->private;
+    TrackPointSettings settings;
+
+    if (!trackpoint_read_watch_events(fd))
+        return;
+
+    /* A failed read means psmouse is reconnecting the device. */
+    if (!trackpoint_get_settings(local, &settings))
+        return;
+
+    if (settings.sensitivity != priv->core.sensitivity)
+        update_property(local->dev, prop_sensitivity, 8, 1,
+                        &settings.sensitivity);
+    if (settings.speed != priv->speed)
+        update_property(local->dev, prop_speed, 8, 1, &settings.speed);
+    if (settings.press_to_select != priv->core.press_to_select)
+        update_property(local->dev, prop_press_to_select, 8, 1,
+                        &settings.press_to_select);
+    if (settings.press_to_select_threshold != priv->core.press_to_select_threshold)
+        update_property(local->dev, prop_press_to_select_threshold, 8, 1,
+                        &settings.press_to_select_threshold);
+}
+
+static void
+watch_trackpoint_settings (InputInfoPtr info)
+{
+    PointingStickPrivate *priv = info->private;
+
+    if (!priv->core.is_trackpoint || priv->sysfs_watch_fd != -1)
+        return;
+
+    priv->sysfs_watch_fd = trackpoint_watch_settings(info);
+    if (priv->sysfs_watch_fd == -1) {
+        xf86Msg(X_WARNING, "%s: cannot watch TrackPoint settings\n", info->name);
+        return;
+    }
+
+    priv->sysfs_watch_handler = xf86AddGeneralHandler(priv->sysfs_watch_fd,
+                                                      sync_trackpoint_settings,
+                                                      info);
+}
+
+static void
+unwatch_trackpoint_settings (InputInfoPtr info)
+{
+    PointingStickPrivate *priv = info->private;
+
+    if (priv->sysfs_watch_handler) {
+        xf86RemoveGeneralHandler(priv->sysfs_watch_handler);
+        priv->sysfs_watch_handler = NULL;
+    }
+    if (priv->sysfs_watch_fd != -1) {
+        close(priv->sysfs_watch_fd);
+        priv->sysfs_watch_fd = -1;
+    }
+}
+
+#if GET_ABI_MAJOR(ABI_XINPUT_VERSION) >= 7
+#define STYK_ACCEL_MIN_VELOCITY 0.5
+#define STYK_ACCEL_MAX_VELOCITY 2.5
+
+/*
+ * The core already scales Styk motion linearly with pressure, which is what
+ * the user controls the speed with, so slow and medium pushes are passed
+ * through unchanged.  Only fast pushes (in units per ms) ramp smoothly up
+ * to the acceleration set with the pointer control, without the server's
+ * own curve being stacked on the core's gain.
+ */
+#if GET_ABI_MAJOR(ABI_XINPUT_VERSION) >= 14
+static double
+styk_acceleration_profile (DeviceIntPtr      device,
+                           DeviceVelocityPtr vel,
+                           double            velocity,
+                           double            threshold,
+                           double            acc)
+#else
+static float
+styk_acceleration_profile (DeviceIntPtr      device,
+                           DeviceVelocityPtr vel,
+                           float             velocity,
+                           float             threshold,
+                           float             acc)
+#endif
+{
+    double t;
+
+    if (acc <= 1 || velocity <= STYK_ACCEL_MIN_VELOCITY)
+        return 1;
+    if (velocity >= STYK_ACCEL_MAX_VELOCITY)
+        return acc;
+
+    t = (velocity - STYK_ACCEL_MIN_VELOCITY) /
+        (STYK_ACCEL_MAX_VELOCITY - STYK_ACCEL_MIN_VELOCITY);
+    return 1 + (acc - 1) * t * t * (3 - 2 * t);
+}
+
+/*
+ * TrackPoint firmware applies its own transfer function (Sensitivity and
+ * Speed), so server acceleration is switched off, which also skips the
+ * velocity estimation.  Styk motion gets the profile above.  Going through
+ * the property keeps the profile changeable with xinput.
+ */
+static void
+init_acceleration (DeviceIntPtr device)
+{
+    InputInfoPtr local = device->public.devicePrivate;
+    PointingStickPrivate *priv = local->private;
+    DeviceVelocityPtr vel;
+    int profile;
+
+    if (!priv->accel_profile)
+        return;
+
+    vel = GetDevicePredictableAccelData(device);
+    if (!vel)
+        return;
+
+    if (priv->core.is_trackpoint) {
+        profile = AccelProfileNone;
+    } else if (priv->core.has_abs_events) {
+        SetDeviceSpecificAccelerationProfile(vel, styk_acceleration_profile);
+        profile = AccelProfileDeviceSpecific;
+    } else {
+        return;
+    }
+
+    XIChangeDeviceProperty(device, XIGetKnownProperty(ACCEL_PROP_PROFILE_NUMBER),
+                           XA_INTEGER, 32, PropModeReplace, 1, &profile, FALSE);
+}
+#endif
+
 static int
 device_init (DeviceIntPtr device)
 {
 #define LOGICAL_MAX_BUTTONS 7
 #define MAX_AXES 2
+    InputInfoPtr local = device->public.devicePrivate;
+    PointingStickPrivate *priv = local->private;
     unsigned char map[LOGICAL_MAX_BUTTONS + 1];
     int i;
 #if GET_ABI_MAJOR(ABI_XINPUT_VERSION) >= 7
@@ -488,11 +1135,205 @@ device_init (DeviceIntPtr device)
         xf86InitValuatorDefaults(device, i);
     }
 
+#if GET_ABI_MAJOR(ABI_XINPUT_VERSION) >= 7
+    init_acceleration(device);
+#endif
+
     init_properties(device);
 
+    /* allocate here, TimerSet() is later called from read_input() */
+    priv->property_timer = TimerSet(NULL, 0, 0, NULL, NULL);
+    priv->rate_timer = TimerSet(NULL, 0, 0, NULL, NULL);
+    priv->motion_timer = TimerSet(NULL, 0, 0, NULL, NULL);
+
+#if GET_ABI_MAJOR(ABI_XINPUT_VERSION) >= 16
+    /* reused for every motion event, see post_event() */
+    priv->valuators = valuator_mask_new(MAX_AXES);
+    if (!priv->valuators)
+        return BadAlloc;
+#endif
+
+    if (priv->telemetry_name) {
+        priv->telemetry = pointingstick_telemetry_create(priv->telemetry_name,
+                                                         local->name);
+        if (!priv->telemetry)
+            xf86Msg(X_WARNING, "%s: cannot create telemetry segment %s: %s\n",
+                    local->name, priv->telemetry_name, strerror(errno));
+    }
+
     return Success;
 }
 
+static void
+grab_device (InputInfoPtr info, Bool grab)
+{
+    PointingStickPrivate *priv = info->private;
+    int rc;
+
+    if (!priv->exclusive_grab)
+        return;
+
+    SYSCALL(rc = ioctl(info->fd, EVIOCGRAB, grab ? (void *)1 : (void *)0));
+    if (rc < 0)
+        xf86Msg(X_WARNING, "%s: %s failed: %s\n", info->name,
+                grab ? "grab" : "ungrab", strerror(errno));
+    else
+        xf86Msg(X_INFO, "%s: %s\n", info->name,
+                grab ? "grabbed exclusively" : "released grab");
+}
+
+#ifdef EVIOCSMASK
+static Bool
+set_event_mask_for_type (InputInfoPtr info,
+                         unsigned int type,
+                         unsigned long *codes,
+                         size_t codes_size)
+{
+    struct input_mask mask;
+    int rc;
+
+    mask.type = type;
+    mask.codes_size = codes_size;
+    mask.codes_ptr = (unsigned long)codes;
+
+    SYSCALL(rc = ioctl(info->fd, EVIOCSMASK, &mask));
+    return rc == 0;
+}
+#endif
+
+/*
+ * Ask evdev to deliver only the events read_event_until_sync() consumes,
+ * so that e.g. BTN_TOOL_FINGER, MSC_SCAN or unused axes do not cost a
+ * wakeup.  EV_SYN is never filtered by the kernel.
+ */
+static void
+set_event_mask (InputInfoPtr info)
+{
+#ifdef EVIOCSMASK
+    PointingStickPrivate *priv = info->private;
+    unsigned long types[NLONGS(EV_CNT)] = {0};
+    unsigned long keys[NLONGS(KEY_CNT)] = {0};
+    unsigned long axes[NLONGS(ABS_CNT > REL_CNT ? ABS_CNT : REL_CNT)] = {0};
+    unsigned int axes_type;
+
+    SetBit(EV_KEY, types);
+    SetBit(BTN_LEFT, keys);
+    SetBit(BTN_RIGHT, keys);
+    SetBit(BTN_MIDDLE, keys);
+
+    if (priv->core.has_abs_events) {
+        axes_type = EV_ABS;
+        SetBit(ABS_X, axes);
+        SetBit(ABS_Y, axes);
+        /* also drives the motion gain, so needed even without press to select */
+        SetBit(ABS_PRESSURE, axes);
+        /* lifting the finger ends press to select */
+        SetBit(BTN_TOUCH, keys);
+    } else {
+        axes_type = EV_REL;
+        SetBit(REL_X, axes);
+        SetBit(REL_Y, axes);
+    }
+    SetBit(axes_type, types);
+
+    if (!set_event_mask_for_type(info, EV_KEY, keys, sizeof(keys)) ||
+        !set_event_mask_for_type(info, axes_type, axes, sizeof(axes)) ||
+        !set_event_mask_for_type(info, 0, types, sizeof(types))) {
+        if (errno == EINVAL || errno == ENOTTY)
+            xf86Msg(X_INFO, "%s: kernel does not support event masks\n", info->name);
+        else
+            xf86Msg(X_WARNING, "%s: cannot set event mask: %s\n",
+                    info->name, strerror(errno));
+    }
+#endif
+}
+
+/*
+ * The latency budget compares evdev timestamps with GetTimeInMillis(),
+ * which reads CLOCK_MONOTONIC (or its coarse variant); evdev uses
+ * CLOCK_REALTIME unless told otherwise.  Without EVIOCSCLOCKID the budget
+ * stays inactive.
+ */
+static void
+set_clock (InputInfoPtr info)
+{
+    PointingStickPrivate *priv = info->private;
+#ifdef EVIOCSCLOCKID
+    int clock = CLOCK_MONOTONIC;
+    int rc;
+
+    SYSCALL(rc = ioctl(info->fd, EVIOCSCLOCKID, &clock));
+    priv->core.monotonic_time = (rc == 0);
+    if (rc < 0 && priv->core.latency_budget > 0)
+        xf86Msg(X_WARNING, "%s: cannot set the event clock, latency budget disabled: %s\n",
+                info->name, strerror(errno));
+#else
+    priv->core.monotonic_time = FALSE;
+#endif
+}
+
+/*
+ * psmouse resets the TrackPoint on resume and reconnect, losing what the
+ * driver wrote.  The hardware values are read back in one batch and only
+ * those differing from the configured ones are rewritten, since each write
+ * is a synchronous PS/2 command.  Called from device_on() before the device
+ * is enabled, so neither the input path nor the settings watch sees it.
+ */
+static void
+restore_trackpoint_settings (InputInfoPtr info)
+{
+    PointingStickPrivate *priv = info->private;
+    TrackPointSettings settings;
+    int restored = 0;
+
+    if (!priv->core.is_trackpoint)
+        return;
+
+    if (!trackpoint_get_settings(info, &settings)) {
+        xf86Msg(X_WARNING, "%s: cannot read back TrackPoint settings\n", info->name);
+        return;
+    }
+
+    if (settings.sensitivity != priv->core.sensitivity) {
+        trackpoint_set_sensitivity(info, priv->core.sensitivity);
+        restored++;
+    }
+    if (priv->speed > 0 && settings.speed != priv->speed) {
+        trackpoint_set_speed(info, priv->speed);
+        restored++;
+    }
+    if (settings.press_to_select != priv->core.press_to_select) {
+        trackpoint_set_press_to_select(info, priv->core.press_to_select);
+        restored++;
+    }
+    if (settings.press_to_select_threshold != priv->core.press_to_select_threshold) {
+        trackpoint_set_press_to_select_threshold(info, priv->core.press_to_select_threshold);
+        restored++;
+    }
+
+    if (restored)
+        xf86Msg(X_INFO, "%s: restored %d TrackPoint setting(s)\n", info->name, restored);
+}
+
+static void
+init_report_rate (InputInfoPtr info)
+{
+    PointingStickPrivate *priv = info->private;
+
+    if (!priv->core.is_trackpoint)
+        return;
+
+    if (priv->resolution > 0 && trackpoint_get_resolution(info) != priv->resolution)
+        trackpoint_set_resolution(info, priv->resolution);
+
+    priv->rate_active = FALSE;
+    priv->rate_active_frames = 0;
+    priv->rate_switched = GetTimeInMillis();
+    priv->saved_rate = trackpoint_get_rate(info);
+    if (priv->adaptive_rate)
+        set_report_rate(info, priv->idle_rate);
+}
+
 static int
 device_on (DeviceIntPtr device)
 {
@@ -508,7 +1349,13 @@ device_on (DeviceIntPtr device)
         return BadAccess;
     }
 
+    grab_device(info, TRUE);
+    set_event_mask(info);
+    set_clock(info);
+    restore_trackpoint_settings(info);
     xf86AddEnabledDevice(info);
+    watch_trackpoint_settings(info);
+    init_report_rate(info);
     device->public.on = TRUE;
 
     return Success;
@@ -526,13 +1373,22 @@ device_off (DeviceIntPtr device)
 
     if (info->fd != -1) {
         xf86RemoveEnabledDevice(info);
+        grab_device(info, FALSE);
         xf86CloseSerial(info->fd);
         info->fd = -1;
     }
 
+    TimerCancel(priv->rate_timer);
+    if (priv->core.is_trackpoint && priv->adaptive_rate)
+        restore_report_rate(info);
+
+    unwatch_trackpoint_settings(info);
     free(priv->trackpoint_sysfs_path);
     priv->trackpoint_sysfs_path = NULL;
 
+    TimerCancel(priv->property_timer);
+    TimerCancel(priv->motion_timer);
+
     device->public.on = FALSE;
 
     return Success;
@@ -549,9 +1405,24 @@ device_close (DeviceIntPtr device)
         xf86CloseSerial(info->fd);
         info->fd = -1;
     }
+    unwatch_trackpoint_settings(info);
     free(priv->trackpoint_sysfs_path);
     priv->trackpoint_sysfs_path = NULL;
 
+    TimerFree(priv->property_timer);
+    priv->property_timer = NULL;
+    TimerFree(priv->rate_timer);
+    priv->rate_timer = NULL;
+    TimerFree(priv->motion_timer);
+    priv->motion_timer = NULL;
+
+    pointingstick_telemetry_destroy(priv->telemetry, priv->telemetry_name);
+    priv->telemetry = NULL;
+
+#if GET_ABI_MAJOR(ABI_XINPUT_VERSION) >= 16
+    valuator_mask_free(&priv->valuators);
+#endif
+
     return Success;
 }
 
@@ -581,6 +1452,51 @@ device_control (DeviceIntPtr    device,
     return ret;
 }
 
+static void
+remove_gone_device (InputInfoPtr info)
+{
+    xf86MsgVerb(X_NONE, 0, "%s: device removed\n", info->name);
+    xf86RemoveEnabledDevice(info);
+    xf86CloseSerial(info->fd);
+    info->fd = -1;
+}
+
+/*
+ * Token bucket: READ_ERROR_BURST messages, then one more per
+ * READ_ERROR_REFILL_INTERVAL ms.  Every error is still counted.
+ */
+static void
+log_read_error (InputInfoPtr info, const char *error)
+{
+    PointingStickPrivate *priv = info->private;
+    Time now = GetTimeInMillis();
+    int refill;
+
+    priv->read_errors++;
+    priv->read_errors_changed = TRUE;
+    if (priv->telemetry) {
+        pointingstick_telemetry_begin(priv->telemetry);
+        priv->telemetry->read_errors = priv->read_errors;
+        pointingstick_telemetry_end(priv->telemetry);
+    }
+    schedule_property_update(info);
+
+    refill = (now - priv->read_error_refilled) / READ_ERROR_REFILL_INTERVAL;
+    if (refill > 0) {
+        priv->read_error_tokens += refill;
+        if (priv->read_error_tokens > READ_ERROR_BURST)
+            priv->read_error_tokens = READ_ERROR_BURST;
+        priv->read_error_refilled += refill * READ_ERROR_REFILL_INTERVAL;
+    }
+
+    if (priv->read_error_tokens <= 0)
+        return;
+
+    priv->read_error_tokens--;
+    xf86MsgVerb(X_NONE, 0, "%s: Read error %s%s\n", info->name, error,
+                priv->read_error_tokens ? "" : " (suppressing further messages)");
+}
+
 /* this function is based on SynapticsReadEvent() in xf86-input-synaptics/src/evcomm.c. */
 static Bool
 read_event (InputInfoPtr info, struct input_event *ev)
@@ -589,11 +1505,13 @@ read_event (InputInfoPtr info, struct input_event *ev)
 
     len = read(info->fd, ev, sizeof(*ev));
     if (len <= 0) {
-        if (errno != EAGAIN)
-            xf86MsgVerb(X_NONE, 0, "%s: Read error %s\n", info->name, strerror(errno));
+        if (len == 0 || errno == ENODEV)
+            remove_gone_device(info);
+        else if (errno != EAGAIN)
+            log_read_error(info, strerror(errno));
         return FALSE;
     } else if (len % sizeof(*ev)) {
-        xf86MsgVerb(X_NONE, 0, "%s: Read error, invalid number of bytes.", info->name);
+        log_read_error(info, "invalid number of bytes");
         return FALSE;
     }
 
@@ -605,166 +1523,197 @@ read_event_until_sync (InputInfoPtr info)
 {
     struct input_event ev;
     PointingStickPrivate *priv = info->private;
-    int v;
-
-    if (priv->is_trackpoint) {
-        priv->x = 0;
-        priv->y = 0;
-    }
 
     while (read_event(info, &ev)) {
-        switch (ev.type) {
-        case EV_SYN:
-            switch (ev.code) {
-            case SYN_REPORT:
-                return TRUE;
-                break;
-            }
-            break;
-        case EV_KEY:
-            v = (ev.value ? 1 : 0);
-            switch (ev.code) {
-            case BTN_LEFT:
-                priv->left_button = v;
-                break;
-            case BTN_RIGHT:
-                priv->right_button = v;
-                break;
-            case BTN_MIDDLE:
-                priv->middle_button = v;
-                break;
-            case BTN_TOOL_FINGER:
-                break;
-            case BTN_TOUCH:
-                priv->button_touched = v;
-                break;
-            }
-            break;
-        case EV_REL:
-            switch (ev.code) {
-            case REL_X:
-                priv->x += ev.value;
-                break;
-            case REL_Y:
-                priv->y += ev.value;
-                break;
-            }
-            break;
-        case EV_ABS:
-            switch (ev.code) {
-            case ABS_X:
-                priv->x = ev.value;
-                break;
-            case ABS_Y:
-                priv->y = ev.value;
-                break;
-            case ABS_PRESSURE:
-                priv->pressure = ev.value;
-                break;
-            }
-            break;
+        if (pointingstick_core_handle_event(&priv->core, &ev)) {
+            PROBE4(frame, info->name, priv->core.x, priv->core.y, priv->core.pressure);
+            return TRUE;
         }
     }
     return FALSE;
 }
 
-static Bool
-handle_middle_button (InputInfoPtr local)
+#define RATE_ACTIVE_FRAMES 4
+#define RATE_ACTIVE_WINDOW 250
+#define RATE_MIN_HOLD 500
+
+/*
+ * Reprogramming the rate is a synchronous PS/2 command, so it is done from
+ * a timer rather than from read_input().  The rate is raised only after a
+ * few reports within a short window and dropped only after rate_idle_timeout
+ * without reports; either switch is held for at least RATE_MIN_HOLD ms.
+ */
+static CARD32
+update_report_rate (OsTimerPtr timer, CARD32 now, pointer arg)
 {
+    InputInfoPtr local = arg;
     PointingStickPrivate *priv = local->private;
-
-    if (priv->middle_button) {
-        if (!priv->middle_button_is_pressed) {
-            priv->middle_button_is_pressed = TRUE;
-            priv->middle_button_click_expires = priv->middle_button_timeout +
-                GetTimeInMillis();
-            return TRUE;
+    int idle, remaining;
+
+    if (!priv->adaptive_rate)
+        return 0;
+
+    if (!priv->rate_active) {
+        remaining = RATE_MIN_HOLD - (int)(now - priv->rate_switched);
+        if (remaining > 0)
+            return remaining;
+        if (now - priv->last_activity > RATE_ACTIVE_WINDOW) {
+            priv->rate_active_frames = 0;
+            return 0;
         }
-    } else {
-        int ms;
+        set_report_rate(local, priv->active_rate);
+        priv->rate_active = TRUE;
+        priv->rate_switched = now;
+    }
 
-        if (!priv->middle_button_is_pressed)
-            return FALSE;
+    idle = now - priv->last_activity;
+    remaining = priv->rate_idle_timeout - idle;
+    if (remaining < RATE_MIN_HOLD - (int)(now - priv->rate_switched))
+        remaining = RATE_MIN_HOLD - (int)(now - priv->rate_switched);
+    if (remaining > 0)
+        return remaining;
 
-        priv->middle_button_is_pressed = FALSE;
-        ms = priv->middle_button_click_expires - GetTimeInMillis();
-        if (ms > 0) {
-            xf86PostButtonEvent(local->dev, 0, 2, 1, 0, 0);
-            xf86PostButtonEvent(local->dev, 0, 2, 0, 0, 0);
-            return TRUE;
-        }
-    }
-    return FALSE;
+    set_report_rate(local, priv->idle_rate);
+    priv->rate_active = FALSE;
+    priv->rate_active_frames = 0;
+    priv->rate_switched = now;
+
+    return 0;
 }
 
 static void
-post_event (InputInfoPtr local)
+track_activity (InputInfoPtr local)
 {
     PointingStickPrivate *priv = local->private;
-    int x, y;
+    Time now;
 
-    xf86PostButtonEvent(local->dev, 0, 1, priv->left_button, 0, 0);
-    xf86PostButtonEvent(local->dev, 0, 3, priv->right_button, 0, 0);
+    if (!priv->adaptive_rate)
+        return;
 
-    if (!priv->is_trackpoint && priv->press_to_select) {
-        if (priv->pressure > priv->press_to_select_threshold) {
-            priv->press_to_selecting = TRUE;
-            xf86PostButtonEvent(local->dev, 0, 1, 1, 0, 0);
-        } else if (priv->press_to_selecting) {
-            priv->press_to_selecting = FALSE;
-            xf86PostButtonEvent(local->dev, 0, 1, 0, 0, 0);
-        }
-    }
+    now = GetTimeInMillis();
+    priv->last_activity = now;
+    if (priv->rate_active)
+        return;
 
-    if (priv->scrolling) {
-        if (handle_middle_button(local))
-            return;
-    } else {
-        xf86PostButtonEvent(local->dev, 0, 2, priv->middle_button, 0, 0);
+    if (now - priv->rate_window_start > RATE_ACTIVE_WINDOW) {
+        priv->rate_window_start = now;
+        priv->rate_active_frames = 0;
     }
+    if (++priv->rate_active_frames == RATE_ACTIVE_FRAMES)
+        priv->rate_timer = TimerSet(priv->rate_timer, 0, 1,
+                                    update_report_rate, local);
+}
 
-    if (priv->pressure <= 0 || priv->pressure > 250)
-        return;
+static void
+post_motion (InputInfoPtr local, const PointingStickEvent *event)
+{
+#if GET_ABI_MAJOR(ABI_XINPUT_VERSION) >= 16
+    PointingStickPrivate *priv = local->private;
 
-    if (priv->is_trackpoint) {
-        x = priv->x * priv->pressure;
-        y = priv->y * priv->pressure;
-    } else {
-        priv->x = (abs(priv->x) <= 2) ? 0 : priv->x;
-        priv->y = (abs(priv->y) <= 2) ? 0 : priv->y;
-        x = priv->x * priv->pressure / (256 - priv->sensitivity);
-        y = priv->y * priv->pressure / (256 - priv->sensitivity);
-    }
-
-    if (!priv->scrolling || !priv->middle_button_is_pressed) {
-        xf86PostMotionEvent(local->dev,
-                            0, /* is_absolute */
-                            0, /* first_valuator */
-                            2,
-                            x,
-                            y);
-        return;
-    }
+    valuator_mask_zero(priv->valuators);
+    valuator_mask_set_double(priv->valuators, 0, event->dx);
+    valuator_mask_set_double(priv->valuators, 1, event->dy);
+    xf86PostMotionEventM(local->dev, Relative, priv->valuators);
+#else
+    /* no subpixel motion before ValuatorMask took doubles */
+    xf86PostMotionEvent(local->dev,
+                        0, /* is_absolute */
+                        0, /* first_valuator */
+                        2,
+                        (int)event->dx,
+                        (int)event->dy);
+#endif
+}
 
-    if (priv->middle_button_is_pressed) {
-        if (y != 0) {
-            int button = (y < 0) ? 4 : 5;
-            xf86PostButtonEvent(local->dev, 0, button, 1, 0, 0);
-            xf86PostButtonEvent(local->dev, 0, button, 0, 0, 0);
-        }
-        if (x != 0) {
-            int button = (x < 0) ? 6 : 7;
-            xf86PostButtonEvent(local->dev, 0, button, 1, 0, 0);
-            xf86PostButtonEvent(local->dev, 0, button, 0, 0, 0);
+static void
+post_event (InputInfoPtr local, const PointingStickEvent *events, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        const PointingStickEvent *event = &events[i];
+
+        switch (event->type) {
+        case POINTINGSTICK_EVENT_MOTION:
+            PROBE3(motion, local->name, (int)(event->dx * 256), (int)(event->dy * 256));
+            post_motion(local, event);
+            break;
+        case POINTINGSTICK_EVENT_BUTTON:
+            if (event->button < 4)
+                PROBE3(button, local->name, event->button, event->pressed);
+            else if (event->pressed)
+                PROBE2(scroll, local->name, event->button);
+            xf86PostButtonEvent(local->dev, 0, event->button, event->pressed, 0, 0);
+            break;
         }
     }
 }
 
+/*
+ * Posts the motion held back by the motion rate once it is due, so that
+ * nothing is left behind when the stick stops, takes back a motion
+ * prediction the stick did not follow and ends press-to-select dwells.
+ * Runs outside of SIGIO context; the core is shared with read_input().
+ */
+static CARD32
+flush_motion (OsTimerPtr timer, CARD32 now, pointer arg)
+{
+    InputInfoPtr local = arg;
+    PointingStickPrivate *priv = local->private;
+    PointingStickEvent events[POINTINGSTICK_MAX_EVENTS];
+    int sigstate, delay, n = 0;
+
+    sigstate = xf86BlockSIGIO();
+    delay = pointingstick_core_motion_delay(&priv->core, now);
+    if (delay == 0) {
+        n = pointingstick_core_flush_motion(&priv->core, now, events);
+        /* a prediction may still be outstanding */
+        delay = pointingstick_core_motion_delay(&priv->core, now);
+    }
+    if (n > 0)
+        post_event(local, events, n);
+    xf86UnblockSIGIO(sigstate);
+
+    return delay > 0 ? delay : 0;
+}
+
 static void
 read_input (InputInfoPtr local)
 {
-    while (read_event_until_sync(local))
-        post_event(local);
+    PointingStickPrivate *priv = local->private;
+    PointingStickEvent events[POINTINGSTICK_MAX_EVENTS];
+    CARD32 now;
+    int x, y;
+    int n, delay;
+
+    while (read_event_until_sync(local)) {
+        now = GetTimeInMillis();
+        x = priv->core.x;
+        y = priv->core.y;
+        n = pointingstick_core_process_frame(&priv->core, now, events);
+        if (priv->telemetry)
+            pointingstick_telemetry_record_frame(priv->telemetry, &priv->core,
+                                                 now, x, y, events, n);
+        if (priv->core.drift_baseline_changed)
+            schedule_property_update(local);
+        delay = pointingstick_core_motion_delay(&priv->core, now);
+        if (delay >= 0)
+            priv->motion_timer = TimerSet(priv->motion_timer, 0, delay > 0 ? delay : 1,
+                                          flush_motion, local);
+        if (priv->core.folded_frames_changed)
+            schedule_property_update(local);
+        if (n == 0 && !priv->core.motion_pending)
+            continue;
+        track_activity(local);
+        post_event(local, events, n);
+    }
+
+    /* motion folded from a backlog goes out once the backlog is drained */
+    now = GetTimeInMillis();
+    if (pointingstick_core_motion_delay(&priv->core, now) == 0) {
+        n = pointingstick_core_flush_motion(&priv->core, now, events);
+        post_event(local, events, n);
+    }
 }
 
 /*
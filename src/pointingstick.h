@@ -23,25 +23,38 @@
 
 typedef struct _PointingStickPrivateRec
 {
-    int x;
-    int y;
-    int pressure;
-    Bool button_touched;
-    Bool left_button;
-    Bool right_button;
-    Bool middle_button;
-    int sensitivity;
+    PointingStickCore core;
     int speed;
-    Bool scrolling;
-    Bool middle_button_is_pressed;
-    Time middle_button_click_expires;
-    Time middle_button_timeout;
-    Bool press_to_select;
-    int press_to_select_threshold;
-    Bool press_to_selecting;
-    Bool has_abs_events;
-    Bool is_trackpoint;
+    Bool exclusive_grab;
+    Bool accel_profile;
+    char *sysfs_root;
     char *trackpoint_sysfs_path;
+    int sysfs_watch_fd;
+    pointer sysfs_watch_handler;
+    Bool updating_properties;
+    OsTimerPtr property_timer;
+    Bool adaptive_rate;
+    int idle_rate;
+    int active_rate;
+    int saved_rate;
+    int rate_idle_timeout;
+    int resolution;
+    Bool rate_active;
+    int rate_active_frames;
+    Time rate_window_start;
+    Time rate_switched;
+    Time last_activity;
+    OsTimerPtr rate_timer;
+    OsTimerPtr motion_timer;
+    int read_errors;
+    Bool read_errors_changed;
+    int read_error_tokens;
+    Time read_error_refilled;
+    char *telemetry_name;
+    PointingStickTelemetry *telemetry;
+#if GET_ABI_MAJOR(ABI_XINPUT_VERSION) >= 16
+    ValuatorMask *valuators;
+#endif
 } PointingStickPrivate;
 /*
 vi:ts=4:nowrap:ai:expandtab:sw=4
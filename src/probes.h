@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2010 Hiroyuki Ikezoe
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Static tracepoints, provider "pointingstick", built in with
+ * --enable-sdt.  An unattached probe is a single nop, so they stay in
+ * production builds; list them with e.g.
+ *
+ *   bpftrace -l 'usdt:/usr/lib/xorg/modules/input/pointingstick_drv.so:*'
+ *
+ * Without --enable-sdt the macros expand to nothing.  Arguments must be
+ * integers or pointers; motion is passed in 1/256 units.
+ *
+ *   frame (device, x, y, pressure)         a frame was read
+ *   motion (device, dx, dy)                motion is posted
+ *   button (device, button, pressed)       button 1 to 3 is posted
+ *   scroll (device, button)                a button 4 to 7 click is posted
+ *   middle_button (click, held ms)         the middle button was released
+ *   sysfs_read_start (attribute)
+ *   sysfs_read_end (attribute, value)
+ *   sysfs_write_start (attribute, value)
+ *   sysfs_write_end (attribute, result)
+ */
+
+#ifndef _POINTINGSTICK_PROBES_H_
+#define _POINTINGSTICK_PROBES_H_
+
+#ifdef HAVE_SDT
+#include <sys/sdt.h>
+
+#define PROBE1(name, a) \
+    DTRACE_PROBE1(pointingstick, name, a)
+#define PROBE2(name, a, b) \
+    DTRACE_PROBE2(pointingstick, name, a, b)
+#define PROBE3(name, a, b, c) \
+    DTRACE_PROBE3(pointingstick, name, a, b, c)
+#define PROBE4(name, a, b, c, d) \
+    DTRACE_PROBE4(pointingstick, name, a, b, c, d)
+#else
+#define PROBE1(name, a) do { } while (0)
+#define PROBE2(name, a, b) do { } while (0)
+#define PROBE3(name, a, b, c) do { } while (0)
+#define PROBE4(name, a, b, c, d) do { } while (0)
+#endif
+
+#endif
+
+/*
+vi:ts=4:nowrap:ai:expandtab:sw=4
+*/
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2010 Hiroyuki Ikezoe
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * TrackPoint discovery and attribute access on a serio sysfs tree.  This
+ * file does not depend on the X server so that it can be exercised and
+ * timed against synthetic trees, see tools/make-fake-sysfs.sh.
+ */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "trackpoint-sysfs.h"
+
+static int
+serio_filter (const struct dirent *name)
+{
+    if (name->d_type != DT_DIR)
+        return 0;
+
+    return !strncmp(name->d_name, "serio", 5);
+}
+
+static int
+sensitivity_filter (const struct dirent *name)
+{
+    if (name->d_type != DT_REG)
+        return 0;
+
+    return !strcmp(name->d_name, "sensitivity");
+}
+
+static int
+find_sensitivity (const char *base_path)
+{
+    struct dirent **filelist;
+    int n;
+
+    n = scandir(base_path, &filelist, sensitivity_filter, alphasort);
+    if (n <= 0)
+        return 0;
+
+    while (n--)
+        free(filelist[n]);
+    free(filelist);
+
+    return 1;
+}
+
+static int
+input_filter (const struct dirent *name)
+{
+    if (name->d_type != DT_DIR)
+        return 0;
+
+    return !strncmp(name->d_name, "input", 5);
+}
+
+static int
+is_equal_device_name (const char *device_name, const char *device_name_path)
+{
+    int ret = 0;
+    FILE *file;
+    char name[1024];
+    size_t read_size;
+
+    if (access(device_name_path, F_OK) != 0)
+        return 0;
+
+    file = fopen(device_name_path, "r");
+    if (!file)
+        return 0;
+
+    memset(name, 0, sizeof(name));
+    read_size = fread(name, 1, sizeof(name), file);
+    if (read_size > 0 && !strncmp(name, device_name, read_size - 1))
+        ret = 1;
+
+    fclose(file);
+    return ret;
+}
+
+static int
+check_device_name (const char *device_name, const char *base_path)
+{
+    struct dirent **filelist;
+    int i = 0, n;
+    char path[4096];
+    int ret = 0;
+
+    snprintf(path, sizeof(path), "%s/input", base_path);
+    n = scandir(path, &filelist, input_filter, alphasort);
+    if (n <= 0)
+        return 0;
+
+    while (i < n) {
+        char name_path[4096];
+        snprintf(name_path, sizeof(path),
+                 "%s/%s/name", path, filelist[i]->d_name);
+        if (is_equal_device_name(device_name, name_path)) {
+            ret = 1;
+            break;
+        }
+        i++;
+    }
+
+    while (n--)
+        free(filelist[n]);
+    free(filelist);
+
+    return ret;
+}
+
+char *
+trackpoint_sysfs_find (const char *base_path, const char *device_name)
+{
+    struct dirent **seriolist;
+    int i = 0, n;
+    char *serio_path = NULL;
+
+    n = scandir(base_path, &seriolist, serio_filter, alphasort);
+    if (n < 0)
+        return NULL;
+
+    while (i < n) {
+        char path[4096];
+        snprintf(path, sizeof(path),
+                 "%s/%s", base_path, seriolist[i]->d_name);
+        if (find_sensitivity(path) && check_device_name(device_name, path)) {
+            serio_path = strdup(path);
+            break;
+        } else {
+            serio_path = trackpoint_sysfs_find(path, device_name);
+            if (serio_path)
+                break;
+        }
+        i++;
+    }
+
+    while (n--)
+        free(seriolist[n]);
+    free(seriolist);
+
+    return serio_path;
+}
+
+int
+trackpoint_sysfs_get_attribute (const char *sysfs_path,
+                                const char *attribute)
+{
+    FILE *file;
+    char attribute_path[4096];
+    char value_string[4]; /* including a line feed */
+    size_t read_size;
+    int value = -1;
+
+    snprintf(attribute_path, sizeof(attribute_path),
+             "%s/%s", sysfs_path, attribute);
+
+    file = fopen(attribute_path, "r");
+    if (!file)
+        return -1;
+
+    memset(value_string, 0, sizeof(value_string));
+    read_size = fread(value_string, 1, sizeof(value_string), file);
+    if (read_size > 0) {
+        value_string[read_size - 1] = '\0';
+        value = atoi(value_string);
+    }
+    fclose(file);
+
+    return value;
+}
+
+int
+trackpoint_sysfs_set_attribute (const char *sysfs_path,
+                                const char *attribute,
+                                int value)
+{
+    FILE *file;
+    char attribute_path[4096];
+    char value_string[4];
+    int ret = 0;
+
+    snprintf(attribute_path, sizeof(attribute_path),
+             "%s/%s", sysfs_path, attribute);
+
+    file = fopen(attribute_path, "r+");
+    if (!file)
+        return -1;
+
+    snprintf(value_string, sizeof(value_string), "%d", value);
+    if (fwrite(value_string, strlen(value_string), 1, file) != 1)
+        ret = -1;
+    if (fclose(file) != 0)
+        ret = -1;
+
+    return ret;
+}
+
+/*
+vi:ts=4:nowrap:ai:expandtab:sw=4
+*/
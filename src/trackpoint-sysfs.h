@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2010 Hiroyuki Ikezoe
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _TRACKPOINT_SYSFS_H_
+#define _TRACKPOINT_SYSFS_H_
+
+#define TRACKPOINT_SYSFS_ROOT "/sys/devices/platform/i8042"
+
+/* overrides TRACKPOINT_SYSFS_ROOT unless the SysfsRoot option is given */
+#define TRACKPOINT_SYSFS_ROOT_ENV "POINTINGSTICK_SYSFS_ROOT"
+
+char *trackpoint_sysfs_find          (const char *base_path,
+                                      const char *device_name);
+int   trackpoint_sysfs_get_attribute (const char *sysfs_path,
+                                      const char *attribute);
+int   trackpoint_sysfs_set_attribute (const char *sysfs_path,
+                                      const char *attribute,
+                                      int         value);
+
+#endif
+
+/*
+vi:ts=4:nowrap:ai:expandtab:sw=4
+*/
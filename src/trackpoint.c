@@ -25,156 +25,27 @@
 #include "config.h"
 #endif
 
-#include <dirent.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
+#include <sys/inotify.h>
 
 #include <xf86.h>
 #include <xf86Xinput.h>
 
 #include "trackpoint.h"
+#include "trackpoint-sysfs.h"
+#include "pointingstick-core.h"
+#include "pointingstick-telemetry.h"
 #include "pointingstick.h"
-
-#define SERIO_SYSFS_PATH "/sys/devices/platform/i8042"
-
-static int
-serio_filter (const struct dirent *name)
-{
-    if (name->d_type != DT_DIR)
-        return 0;
-
-    return !strncmp(name->d_name, "serio", 5);
-}
-
-static int
-sensitivity_filter (const struct dirent *name)
-{
-    if (name->d_type != DT_REG)
-        return 0;
-
-    return !strcmp(name->d_name, "sensitivity");
-}
-
-static Bool
-find_sensitivity (const char *base_path)
-{
-    struct dirent **filelist;
-    int n;
-
-    n = scandir(base_path, &filelist, sensitivity_filter, alphasort);
-    if (n <= 0)
-        return FALSE;
-
-    while (n--)
-        free(filelist[n]);
-    free(filelist);
-
-    return TRUE;
-}
-
-static int
-input_filter (const struct dirent *name)
-{
-    if (name->d_type != DT_DIR)
-        return 0;
-
-    return !strncmp(name->d_name, "input", 5);
-}
-
-static Bool
-is_equal_device_name (InputInfoPtr local, const char *device_name_path)
-{
-    Bool ret = FALSE;
-    FILE *file;
-    char name[1024];
-    size_t read_size;
-
-    if (access(device_name_path, F_OK) != 0)
-        return FALSE;
-
-    file = fopen(device_name_path, "r");
-    if (!file)
-        return FALSE;
-
-    memset(name, 0, sizeof(name));
-    read_size = fread(name, 1, sizeof(name), file);
-    if (read_size > 0 && !strncmp(name, local->name, read_size - 1))
-        ret = TRUE;
-
-    fclose(file);
-    return ret;
-}
-
-static Bool
-check_device_name (InputInfoPtr local, const char *base_path)
-{
-    struct dirent **filelist;
-    int i = 0, n;
-    char path[4096];
-    Bool ret = FALSE;
-
-    snprintf(path, sizeof(path), "%s/input", base_path);
-    n = scandir(path, &filelist, input_filter, alphasort);
-    if (n <= 0)
-        return FALSE;
-
-    while (i < n) {
-        char name_path[4096];
-        snprintf(name_path, sizeof(path),
-                 "%s/%s/name", path, filelist[i]->d_name);
-        if (is_equal_device_name(local, name_path)) {
-            ret = TRUE;
-            break;
-        }
-        i++;
-    }
-
-    while (n--)
-        free(filelist[n]);
-    free(filelist);
-
-    return ret;
-}
-
-static char *
-find_trackpoint_sysfs_path (InputInfoPtr local, const char *base_path)
-{
-    struct dirent **seriolist;
-    int i = 0, n;
-    char *serio_path = NULL;
-
-    n = scandir(base_path, &seriolist, serio_filter, alphasort);
-    if (n < 0)
-        return NULL;
-
-    while (i < n) {
-        char path[4096];
-        snprintf(path, sizeof(path),
-                 "%s/%s", base_path, seriolist[i]->d_name);
-        if (find_sensitivity(path) && check_device_name(local, path)) {
-            serio_path = strdup(path);
-            break;
-        } else {
-            serio_path = find_trackpoint_sysfs_path(local, path);
-            if (serio_path)
-                break;
-        }
-        i++;
-    }
-
-    while (n--)
-        free(seriolist[n]);
-    free(seriolist);
-
-    return serio_path;
-}
+#include "probes.h"
 
 static const char *
 get_trackpoint_sysfs_path (InputInfoPtr local)
 {
     PointingStickPrivate *priv = local->private;
     if (!priv->trackpoint_sysfs_path)
-        priv->trackpoint_sysfs_path = find_trackpoint_sysfs_path(local, SERIO_SYSFS_PATH);
+        priv->trackpoint_sysfs_path = trackpoint_sysfs_find(priv->sysfs_root, local->name);
 
     return priv->trackpoint_sysfs_path;
 }
@@ -189,34 +60,22 @@ static int
 trackpoint_get_property (InputInfoPtr local,
                          const char *property_name)
 {
-    FILE *file;
-    char property_path[4096];
-    char property_string[4]; /* including a line feed */
-    size_t read_size;
-    int property = -1;
+    const char *sysfs_path;
+    int value;
 
     PointingStickPrivate *priv = local->private;
-    if (!priv->is_trackpoint)
+    if (!priv->core.is_trackpoint)
         return -1;
 
-    snprintf(property_path, sizeof(property_path),
-             "%s/%s",
-             get_trackpoint_sysfs_path(local),
-             property_name);
-
-    file = fopen(property_path, "r");
-    if (!file)
+    sysfs_path = get_trackpoint_sysfs_path(local);
+    if (!sysfs_path)
         return -1;
 
-    memset(property_string, 0, sizeof(property_string));
-    read_size = fread(property_string, 1, sizeof(property_string), file);
-    if (read_size > 0) {
-        property_string[read_size - 1] = '\0';
-        property = atoi(property_string);
-    }
-    fclose(file);
+    PROBE1(sysfs_read_start, property_name);
+    value = trackpoint_sysfs_get_attribute(sysfs_path, property_name);
+    PROBE2(sysfs_read_end, property_name, value);
 
-    return property;
+    return value;
 }
 
 static int
@@ -224,33 +83,24 @@ trackpoint_set_property (InputInfoPtr local,
                          const char *property_name,
                          int property_value)
 {
-    FILE *file;
-    char property_path[4096];
-    char property_string[4];
-    size_t written_size;
-    int ret = Success;
+    const char *sysfs_path;
+    int rc;
 
     PointingStickPrivate *priv = local->private;
-    if (!priv->is_trackpoint)
+    if (!priv->core.is_trackpoint)
         return BadRequest;
 
-    snprintf(property_path, sizeof(property_path),
-             "%s/%s",
-             get_trackpoint_sysfs_path(local),
-             property_name);
-
-    file = fopen(property_path, "r+");
-    if (!file)
+    sysfs_path = get_trackpoint_sysfs_path(local);
+    if (!sysfs_path)
         return BadAccess;
 
-    snprintf(property_string, sizeof(property_string),
-             "%d", property_value);
-    written_size = fwrite(property_string, strlen(property_string), 1, file);
-    if (written_size != strlen(property_string))
-        ret = BadAccess;
-    fclose(file);
+    PROBE2(sysfs_write_start, property_name, property_value);
+    rc = trackpoint_sysfs_set_attribute(sysfs_path, property_name, property_value);
+    PROBE2(sysfs_write_end, property_name, rc);
+    if (rc < 0)
+        return BadAccess;
 
-    return ret;
+    return Success;
 }
 
 int
@@ -328,6 +178,111 @@ trackpoint_set_press_to_select_threshold (InputInfoPtr local, int threshold)
     return trackpoint_set_property(local, "thresh", threshold);
 }
 
+/* rate and resolution are psmouse attributes of the same serio device */
+int
+trackpoint_get_rate (InputInfoPtr local)
+{
+    return trackpoint_get_property(local, "rate");
+}
+
+int
+trackpoint_set_rate (InputInfoPtr local, int rate)
+{
+    return trackpoint_set_property(local, "rate", rate);
+}
+
+int
+trackpoint_get_resolution (InputInfoPtr local)
+{
+    return trackpoint_get_property(local, "resolution");
+}
+
+int
+trackpoint_set_resolution (InputInfoPtr local, int resolution)
+{
+    return trackpoint_set_property(local, "resolution", resolution);
+}
+
+Bool
+trackpoint_get_settings (InputInfoPtr local, TrackPointSettings *settings)
+{
+    settings->sensitivity = trackpoint_get_property(local, "sensitivity");
+    settings->speed = trackpoint_get_property(local, "speed");
+    settings->press_to_select = trackpoint_get_property(local, "press_to_select");
+    settings->press_to_select_threshold = trackpoint_get_property(local, "thresh");
+
+    return settings->sensitivity >= 0 &&
+           settings->speed >= 0 &&
+           settings->press_to_select >= 0 &&
+           settings->press_to_select_threshold >= 0;
+}
+
+/*
+ * Writes to sysfs attributes by other programs (tpconfig, udev rules, ...)
+ * go through the VFS and thus raise IN_MODIFY, so there is no need to poll
+ * the attributes.
+ */
+int
+trackpoint_watch_settings (InputInfoPtr local)
+{
+    static const char *attributes[] = {
+        "sensitivity",
+        "speed",
+        "press_to_select",
+        "thresh"
+    };
+    const char *sysfs_path;
+    int fd;
+    unsigned int i, watched = 0;
+
+    PointingStickPrivate *priv = local->private;
+    if (!priv->core.is_trackpoint)
+        return -1;
+
+    sysfs_path = get_trackpoint_sysfs_path(local);
+    if (!sysfs_path)
+        return -1;
+
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    for (i = 0; i < sizeof(attributes) / sizeof(attributes[0]); i++) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", sysfs_path, attributes[i]);
+        if (inotify_add_watch(fd, path, IN_MODIFY) >= 0)
+            watched++;
+    }
+
+    if (watched == 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+Bool
+trackpoint_read_watch_events (int fd)
+{
+    char buffer[sizeof(struct inotify_event) * 16];
+    ssize_t len;
+    Bool modified = FALSE;
+
+    while ((len = read(fd, buffer, sizeof(buffer))) > 0 || errno == EINTR) {
+        char *p = buffer;
+
+        while (len > 0 && p < buffer + len) {
+            struct inotify_event *event = (struct inotify_event *)p;
+            if (event->mask & IN_MODIFY)
+                modified = TRUE;
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    return modified;
+}
+
 /*
 vi:ts=4:nowrap:ai:expandtab:sw=4
 */
@@ -21,6 +21,14 @@
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+typedef struct _TrackPointSettings
+{
+    int sensitivity;
+    int speed;
+    int press_to_select;
+    int press_to_select_threshold;
+} TrackPointSettings;
+
 Bool pointingstick_is_trackpoint    (InputInfoPtr local);
 int  trackpoint_get_sensitivity     (InputInfoPtr local);
 int  trackpoint_set_sensitivity     (InputInfoPtr local,
@@ -36,6 +44,16 @@ int  trackpoint_get_press_to_select_threshold
 int  trackpoint_set_press_to_select_threshold
                                     (InputInfoPtr local,
                                      int          press_to_select);
+int  trackpoint_get_rate            (InputInfoPtr local);
+int  trackpoint_set_rate            (InputInfoPtr local,
+                                     int          rate);
+int  trackpoint_get_resolution      (InputInfoPtr local);
+int  trackpoint_set_resolution      (InputInfoPtr local,
+                                     int          resolution);
+Bool trackpoint_get_settings        (InputInfoPtr local,
+                                     TrackPointSettings *settings);
+int  trackpoint_watch_settings      (InputInfoPtr local);
+Bool trackpoint_read_watch_events   (int          fd);
 
 /*
 vi:ts=4:nowrap:ai:expandtab:sw=4
@@ -0,0 +1,64 @@
+#! /bin/sh
+#
+# Build a synthetic i8042 serio tree for exercising TrackPoint discovery.
+#
+#   make-fake-sysfs.sh ROOT [DEPTH] [WIDTH] [NAME]
+#
+# Every serio node gets WIDTH serio children down to DEPTH levels, plus the
+# usual non-directory clutter.  The TrackPoint attributes and an input node
+# named NAME are put on the last node discovery visits, the worst case.
+# Point the driver at it with Option "SysfsRoot" or POINTINGSTICK_SYSFS_ROOT;
+# a tmpfs mount keeps the file system out of the measurement.
+
+root=$1
+depth=${2:-3}
+width=${3:-4}
+name=${4:-TPPS/2 IBM TrackPoint}
+
+if test -z "$root"; then
+    echo "Usage: $0 ROOT [DEPTH] [WIDTH] [NAME]" >&2
+    exit 1
+fi
+
+populate () {
+    dir=$1
+    echo "i8042 AUX port" > "$dir/description"
+    echo "serio:ty01pr00id00ex00" > "$dir/modalias"
+    echo "psmouse" > "$dir/drvctl"
+}
+
+build () {
+    parent=$1
+    level=$2
+    if test "$level" -ge "$depth"; then
+        return
+    fi
+    i=0
+    while test "$i" -lt "$width"; do
+        mkdir -p "$parent/serio$i"
+        populate "$parent/serio$i"
+        # subshell, sh has no local variables
+        (build "$parent/serio$i" $((level + 1)))
+        i=$((i + 1))
+    done
+}
+
+mkdir -p "$root" || exit 1
+build "$root" 0
+
+last=`find "$root" -type d -name 'serio*' | LC_ALL=C sort | tail -n 1`
+if test -z "$last"; then
+    echo "$0: DEPTH and WIDTH must be at least 1" >&2
+    exit 1
+fi
+
+echo 128 > "$last/sensitivity"
+echo 97 > "$last/speed"
+echo 0 > "$last/press_to_select"
+echo 8 > "$last/thresh"
+echo 100 > "$last/rate"
+echo 200 > "$last/resolution"
+mkdir -p "$last/input/input5"
+echo "$name" > "$last/input/input5/name"
+
+echo "$last"
@@ -0,0 +1,523 @@
+/*
+ * Copyright (C) 2010 Hiroyuki Ikezoe
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Synthetic pointing stick for load testing the driver without hardware.
+ *
+ * Creates a uinput device with the capabilities is_pointingstick() accepts
+ * and a name matched by xorg.d/pointingstick.conf, then emits motion, click
+ * or scroll patterns at a given report rate.  Note that a uinput TrackPoint
+ * has no serio sysfs node, so the driver treats it as a plain relative
+ * stick.
+ *
+ * With --record nothing is created; the events are written to stdout in
+ * evemu-record format with simulated timestamps, for the replay corpus.
+ */
+
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#define TRACKPOINT_NAME "TPPS/2 IBM TrackPoint"
+#define STYK_NAME "Synaptics USB Styk"
+
+#define STYK_AXIS_MAX 127
+#define STYK_PRESSURE_MAX 255
+
+enum device_type {
+    DEVICE_TRACKPOINT,
+    DEVICE_STYK
+};
+
+enum pattern {
+    PATTERN_CIRCLE,
+    PATTERN_DRIFT,
+    PATTERN_CLICK,
+    PATTERN_SCROLL
+};
+
+struct options {
+    enum device_type type;
+    enum pattern pattern;
+    int rate;
+    int burst;
+    int amplitude;
+    double duration;
+    double settle;
+    const char *name;
+    int record;
+};
+
+struct generator {
+    int fd;
+    struct options options;
+    unsigned long reports; /* generated, whether or not they had events */
+    unsigned long frames;
+    unsigned long events;
+    double phase;
+    int left_button;
+    int middle_button;
+    /* last values sent, the kernel drops repeats of these */
+    int abs_x;
+    int abs_y;
+    int abs_pressure;
+    int touching;
+    int frame_events;
+    unsigned long long time_us;
+};
+
+static volatile sig_atomic_t stopped = 0;
+
+static void
+stop (int signum)
+{
+    (void)signum;
+    stopped = 1;
+}
+
+static int
+emit (struct generator *gen, int type, int code, int value)
+{
+    struct input_event ev;
+
+    if (type != EV_SYN)
+        gen->frame_events++;
+
+    if (gen->options.record) {
+        printf("E: %llu.%06llu %04x %04x %d\n",
+               gen->time_us / 1000000, gen->time_us % 1000000, type, code, value);
+        gen->events++;
+        return 0;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.type = type;
+    ev.code = code;
+    ev.value = value;
+
+    if (write(gen->fd, &ev, sizeof(ev)) != sizeof(ev))
+        return -1;
+
+    gen->events++;
+    return 0;
+}
+
+static int
+set_bit (int fd, unsigned long request, int bit)
+{
+    return ioctl(fd, request, bit);
+}
+
+static int
+create_device (const struct options *options)
+{
+    struct uinput_user_dev dev;
+    int fd;
+
+    fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+    if (fd < 0) {
+        fprintf(stderr, "cannot open /dev/uinput: %s\n", strerror(errno));
+        return -1;
+    }
+
+    memset(&dev, 0, sizeof(dev));
+
+    if (set_bit(fd, UI_SET_EVBIT, EV_SYN) < 0 ||
+        set_bit(fd, UI_SET_EVBIT, EV_KEY) < 0 ||
+        set_bit(fd, UI_SET_KEYBIT, BTN_LEFT) < 0 ||
+        set_bit(fd, UI_SET_KEYBIT, BTN_RIGHT) < 0 ||
+        set_bit(fd, UI_SET_KEYBIT, BTN_MIDDLE) < 0)
+        goto error;
+
+    if (options->type == DEVICE_TRACKPOINT) {
+        if (set_bit(fd, UI_SET_EVBIT, EV_REL) < 0 ||
+            set_bit(fd, UI_SET_RELBIT, REL_X) < 0 ||
+            set_bit(fd, UI_SET_RELBIT, REL_Y) < 0)
+            goto error;
+        dev.id.bustype = BUS_I8042;
+        dev.id.vendor = 0x0002;
+        dev.id.product = 0x000a;
+    } else {
+        if (set_bit(fd, UI_SET_KEYBIT, BTN_TOUCH) < 0 ||
+            set_bit(fd, UI_SET_KEYBIT, BTN_TOOL_FINGER) < 0 ||
+            set_bit(fd, UI_SET_EVBIT, EV_ABS) < 0 ||
+            set_bit(fd, UI_SET_ABSBIT, ABS_X) < 0 ||
+            set_bit(fd, UI_SET_ABSBIT, ABS_Y) < 0 ||
+            set_bit(fd, UI_SET_ABSBIT, ABS_PRESSURE) < 0)
+            goto error;
+        dev.absmin[ABS_X] = -STYK_AXIS_MAX;
+        dev.absmax[ABS_X] = STYK_AXIS_MAX;
+        dev.absmin[ABS_Y] = -STYK_AXIS_MAX;
+        dev.absmax[ABS_Y] = STYK_AXIS_MAX;
+        dev.absmin[ABS_PRESSURE] = 0;
+        dev.absmax[ABS_PRESSURE] = STYK_PRESSURE_MAX;
+        dev.id.bustype = BUS_USB;
+        dev.id.vendor = 0x06cb;
+        dev.id.product = 0x0007;
+    }
+
+    snprintf(dev.name, sizeof(dev.name), "%s", options->name);
+
+    if (write(fd, &dev, sizeof(dev)) != sizeof(dev) ||
+        ioctl(fd, UI_DEV_CREATE) < 0)
+        goto error;
+
+    return fd;
+
+ error:
+    fprintf(stderr, "cannot set up uinput device: %s\n", strerror(errno));
+    close(fd);
+    return -1;
+}
+
+static void
+write_record_header (const struct options *options)
+{
+    printf("# EVEMU 1.3\n");
+    printf("# generated by pointingstick-loadgen\n");
+    printf("N: %s\n", options->name);
+    if (options->type == DEVICE_TRACKPOINT) {
+        printf("I: %04x 0002 000a 0000\n", BUS_I8042);
+    } else {
+        printf("I: %04x 06cb 0007 0000\n", BUS_USB);
+        printf("A: %02x %d %d 0 0 0\n", ABS_X, -STYK_AXIS_MAX, STYK_AXIS_MAX);
+        printf("A: %02x %d %d 0 0 0\n", ABS_Y, -STYK_AXIS_MAX, STYK_AXIS_MAX);
+        printf("A: %02x 0 %d 0 0 0\n", ABS_PRESSURE, STYK_PRESSURE_MAX);
+    }
+}
+
+/*
+ * Like the input core, only changed absolute values and key states are
+ * passed on, and a frame without events gets no SYN_REPORT, so that a
+ * recording looks like one of real hardware.
+ */
+static void
+set_value (struct generator *gen, int type, int code, int *state, int value)
+{
+    if (*state == value)
+        return;
+    *state = value;
+    emit(gen, type, code, value);
+}
+
+static void
+set_button (struct generator *gen, int code, int *state, int value)
+{
+    set_value(gen, EV_KEY, code, state, value);
+}
+
+static void
+emit_motion (struct generator *gen, int x, int y, int pressure)
+{
+    int touching = pressure > 0;
+
+    if (gen->options.type == DEVICE_TRACKPOINT) {
+        if (x)
+            emit(gen, EV_REL, REL_X, x);
+        if (y)
+            emit(gen, EV_REL, REL_Y, y);
+    } else {
+        set_value(gen, EV_ABS, ABS_X, &gen->abs_x, x);
+        set_value(gen, EV_ABS, ABS_Y, &gen->abs_y, y);
+        set_value(gen, EV_ABS, ABS_PRESSURE, &gen->abs_pressure, pressure);
+        if (touching != gen->touching) {
+            gen->touching = touching;
+            emit(gen, EV_KEY, BTN_TOUCH, touching);
+            emit(gen, EV_KEY, BTN_TOOL_FINGER, touching);
+        }
+    }
+}
+
+static void
+emit_sync (struct generator *gen)
+{
+    if (gen->frame_events == 0)
+        return;
+    emit(gen, EV_SYN, SYN_REPORT, 0);
+    gen->frame_events = 0;
+    gen->frames++;
+}
+
+/* One report (SYN_REPORT terminated frame) of the selected pattern. */
+static void
+emit_frame (struct generator *gen)
+{
+    const struct options *options = &gen->options;
+    int amplitude = options->amplitude;
+    unsigned long n = gen->reports;
+    int x = 0, y = 0, pressure = 0;
+
+    switch (options->pattern) {
+    case PATTERN_CIRCLE:
+        gen->phase += 2 * M_PI / 100;
+        if (options->type == DEVICE_TRACKPOINT) {
+            x = lround(amplitude * cos(gen->phase));
+            y = lround(amplitude * sin(gen->phase));
+        } else {
+            x = lround(STYK_AXIS_MAX / 2 * cos(gen->phase));
+            y = lround(STYK_AXIS_MAX / 2 * sin(gen->phase));
+        }
+        pressure = 64;
+        break;
+    case PATTERN_DRIFT:
+        /* an untouched stick creeping by one count now and then */
+        x = (n % 3 == 0) ? 1 : 0;
+        y = (n % 7 == 0) ? -1 : 0;
+        if (options->type == DEVICE_STYK) {
+            x += 3;
+            y -= 3;
+        }
+        pressure = 1;
+        break;
+    case PATTERN_CLICK:
+        set_button(gen, BTN_LEFT, &gen->left_button, (n / 5) % 2);
+        x = (n % 2) ? amplitude : -amplitude;
+        pressure = 32;
+        break;
+    case PATTERN_SCROLL:
+        /* hold the middle button well past the click timeout, then move */
+        set_button(gen, BTN_MIDDLE, &gen->middle_button, (n / 50) % 2 == 0);
+        y = gen->middle_button ? amplitude : 0;
+        pressure = 32;
+        break;
+    }
+
+    emit_motion(gen, x, y, pressure);
+    emit_sync(gen);
+    gen->reports++;
+}
+
+static double
+now_seconds (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+advance (struct timespec *ts, long nsec)
+{
+    ts->tv_nsec += nsec;
+    while (ts->tv_nsec >= 1000000000L) {
+        ts->tv_nsec -= 1000000000L;
+        ts->tv_sec++;
+    }
+}
+
+static void
+run (struct generator *gen)
+{
+    const struct options *options = &gen->options;
+    struct timespec next;
+    double start, elapsed;
+    long period = options->rate > 0 ? 1000000000L / options->rate : 0;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    start = now_seconds();
+
+    while (!stopped && now_seconds() - start < options->duration) {
+        for (i = 0; i < options->burst; i++)
+            emit_frame(gen);
+
+        if (options->record) {
+            /* unpaced reports are taken to arrive every 100 us */
+            gen->time_us += period > 0 ? period / 1000 : 100;
+            if (gen->time_us >= options->duration * 1000000)
+                break;
+        } else if (period > 0) {
+            advance(&next, period);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        }
+    }
+
+    /* leave no button pressed behind */
+    set_button(gen, BTN_LEFT, &gen->left_button, 0);
+    set_button(gen, BTN_MIDDLE, &gen->middle_button, 0);
+    emit_sync(gen);
+
+    elapsed = now_seconds() - start;
+    if (options->record)
+        return;
+    printf("%lu frames, %lu events in %.3f s (%.1f frames/s)\n",
+           gen->frames, gen->events, elapsed,
+           elapsed > 0 ? gen->frames / elapsed : 0.0);
+}
+
+static void
+usage (const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [OPTION]...\n"
+            "  -t, --type=trackpoint|styk      device to mimic (default trackpoint)\n"
+            "  -p, --pattern=circle|drift|click|scroll\n"
+            "                                  what to emit (default circle)\n"
+            "  -r, --rate=HZ                   reports per second, 0 for no pacing\n"
+            "                                  (default 100)\n"
+            "  -b, --burst=N                   reports emitted back to back per\n"
+            "                                  period (default 1)\n"
+            "  -a, --amplitude=N               relative motion per report (default 3)\n"
+            "  -d, --duration=SECONDS          how long to run (default 10)\n"
+            "  -s, --settle=SECONDS            wait for the server to pick up the\n"
+            "                                  device first (default 1)\n"
+            "  -n, --name=NAME                 device name override\n"
+            "  -R, --record                    write evemu-record output to stdout\n"
+            "                                  instead of creating a device\n",
+            program);
+}
+
+static int
+parse_options (int argc, char **argv, struct options *options)
+{
+    static const struct option long_options[] = {
+        { "type", required_argument, NULL, 't' },
+        { "pattern", required_argument, NULL, 'p' },
+        { "rate", required_argument, NULL, 'r' },
+        { "burst", required_argument, NULL, 'b' },
+        { "amplitude", required_argument, NULL, 'a' },
+        { "duration", required_argument, NULL, 'd' },
+        { "settle", required_argument, NULL, 's' },
+        { "name", required_argument, NULL, 'n' },
+        { "record", no_argument, NULL, 'R' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int c;
+
+    options->type = DEVICE_TRACKPOINT;
+    options->pattern = PATTERN_CIRCLE;
+    options->rate = 100;
+    options->burst = 1;
+    options->amplitude = 3;
+    options->duration = 10;
+    options->settle = 1;
+    options->name = NULL;
+    options->record = 0;
+
+    while ((c = getopt_long(argc, argv, "t:p:r:b:a:d:s:n:Rh", long_options, NULL)) != -1) {
+        switch (c) {
+        case 't':
+            if (!strcmp(optarg, "trackpoint"))
+                options->type = DEVICE_TRACKPOINT;
+            else if (!strcmp(optarg, "styk"))
+                options->type = DEVICE_STYK;
+            else
+                return -1;
+            break;
+        case 'p':
+            if (!strcmp(optarg, "circle"))
+                options->pattern = PATTERN_CIRCLE;
+            else if (!strcmp(optarg, "drift"))
+                options->pattern = PATTERN_DRIFT;
+            else if (!strcmp(optarg, "click"))
+                options->pattern = PATTERN_CLICK;
+            else if (!strcmp(optarg, "scroll"))
+                options->pattern = PATTERN_SCROLL;
+            else
+                return -1;
+            break;
+        case 'r':
+            options->rate = atoi(optarg);
+            break;
+        case 'b':
+            options->burst = atoi(optarg);
+            break;
+        case 'a':
+            options->amplitude = atoi(optarg);
+            break;
+        case 'd':
+            options->duration = atof(optarg);
+            break;
+        case 's':
+            options->settle = atof(optarg);
+            break;
+        case 'n':
+            options->name = optarg;
+            break;
+        case 'R':
+            options->record = 1;
+            break;
+        default:
+            return -1;
+        }
+    }
+
+    if (optind != argc || options->rate < 0 || options->burst < 1)
+        return -1;
+
+    if (!options->name)
+        options->name = options->type == DEVICE_TRACKPOINT ? TRACKPOINT_NAME : STYK_NAME;
+
+    return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+    struct generator gen;
+
+    memset(&gen, 0, sizeof(gen));
+    if (parse_options(argc, argv, &gen.options) < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (gen.options.record) {
+        write_record_header(&gen.options);
+        run(&gen);
+        return 0;
+    }
+
+    gen.fd = create_device(&gen.options);
+    if (gen.fd < 0)
+        return 1;
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    if (gen.options.settle > 0)
+        usleep(gen.options.settle * 1000000);
+
+    run(&gen);
+
+    ioctl(gen.fd, UI_DEV_DESTROY);
+    close(gen.fd);
+
+    return 0;
+}
+
+/*
+vi:ts=4:nowrap:ai:expandtab:sw=4
+*/
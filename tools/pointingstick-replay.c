@@ -0,0 +1,507 @@
+/*
+ * Copyright (C) 2010 Hiroyuki Ikezoe
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Replays evemu-record traces through the X independent core, to check
+ * what the driver makes of a recording and to time the per-frame path:
+ *
+ *   pointingstick-replay [-o NAME=VALUE]... [--dump] [--bench N]
+ *                        [--prediction-error] [--still-after MS] TRACE...
+ *
+ * With --still-after it exits with 1 if any trace still moves the pointer
+ * after MS ms, for checks such as drift compensation settling.
+ *
+ * A trace with "A:" lines is taken to be an absolute (Styk) device, one
+ * without them a relative stick, and a TrackPoint if its name says so.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "pointingstick-core.h"
+
+typedef struct _Trace
+{
+    const char *path;
+    char name[256];
+    int has_abs_events;
+    struct input_event *events;
+    int nevents;
+} Trace;
+
+typedef struct _Setting
+{
+    const char *name;
+    int value;
+} Setting;
+
+#define MAX_SETTINGS 16
+
+static Setting settings[MAX_SETTINGS];
+static int nsettings;
+
+static int
+load_trace (Trace *trace, const char *path)
+{
+    FILE *file;
+    char line[1024];
+    int allocated = 0;
+
+    memset(trace, 0, sizeof(*trace));
+    trace->path = path;
+
+    file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long sec, usec;
+        unsigned int type, code;
+        int value;
+
+        if (!strncmp(line, "N: ", 3)) {
+            sscanf(line + 3, "%255[^\n]", trace->name);
+        } else if (!strncmp(line, "A: ", 3)) {
+            trace->has_abs_events = 1;
+        } else if (sscanf(line, "E: %lu.%lu %x %x %d",
+                          &sec, &usec, &type, &code, &value) == 5) {
+            struct input_event *ev;
+
+            if (trace->nevents == allocated) {
+                allocated = allocated ? allocated * 2 : 1024;
+                trace->events = realloc(trace->events,
+                                        allocated * sizeof(*trace->events));
+                if (!trace->events) {
+                    fclose(file);
+                    return -1;
+                }
+            }
+            ev = &trace->events[trace->nevents++];
+            memset(ev, 0, sizeof(*ev));
+            ev->time.tv_sec = sec;
+            ev->time.tv_usec = usec;
+            ev->type = type;
+            ev->code = code;
+            ev->value = value;
+        }
+    }
+
+    fclose(file);
+    return 0;
+}
+
+static int
+parse_setting (const char *argument)
+{
+    const char *value = strchr(argument, '=');
+    char *name;
+
+    if (!value || nsettings == MAX_SETTINGS)
+        return -1;
+
+    name = strndup(argument, value - argument);
+    value++;
+    settings[nsettings].name = name;
+    if (!strcasecmp(value, "on") || !strcasecmp(value, "true"))
+        settings[nsettings].value = 1;
+    else if (!strcasecmp(value, "off") || !strcasecmp(value, "false"))
+        settings[nsettings].value = 0;
+    else
+        settings[nsettings].value = atoi(value);
+    nsettings++;
+    return 0;
+}
+
+static void
+init_core (PointingStickCore *core, const Trace *trace)
+{
+    int i;
+
+    pointingstick_core_init(core, trace->has_abs_events,
+                            !trace->has_abs_events && strstr(trace->name, "TrackPoint"));
+
+    for (i = 0; i < nsettings; i++) {
+        const Setting *setting = &settings[i];
+
+        if (!strcasecmp(setting->name, "Sensitivity"))
+            core->sensitivity = setting->value;
+        else if (!strcasecmp(setting->name, "Scrolling"))
+            core->scrolling = setting->value;
+        else if (!strcasecmp(setting->name, "ScrollDistance"))
+            core->scroll_distance = setting->value;
+        else if (!strcasecmp(setting->name, "ScrollMaxRate"))
+            core->scroll_max_rate = setting->value;
+        else if (!strcasecmp(setting->name, "MiddleButtonTimeout"))
+            core->middle_button_timeout = setting->value;
+        else if (!strcasecmp(setting->name, "PressToSelect"))
+            core->press_to_select = setting->value;
+        else if (!strcasecmp(setting->name, "PressToSelectThreshold"))
+            core->press_to_select_threshold = setting->value;
+        else if (!strcasecmp(setting->name, "PressToSelectReleaseThreshold"))
+            core->press_to_select_release_threshold = setting->value;
+        else if (!strcasecmp(setting->name, "PressToSelectDwell"))
+            core->press_to_select_dwell = setting->value;
+        else if (!strcasecmp(setting->name, "MotionRate"))
+            core->motion_rate = setting->value;
+        else if (!strcasecmp(setting->name, "PredictionHorizon"))
+            core->prediction_horizon = setting->value;
+        else if (!strcasecmp(setting->name, "DriftCompensation"))
+            core->drift_compensation = setting->value;
+        else
+            fprintf(stderr, "unknown setting %s\n", setting->name);
+    }
+}
+
+typedef struct _Position
+{
+    unsigned int time;
+    double x;
+    double y;
+} Position;
+
+typedef struct _Stats
+{
+    unsigned long frames;
+    unsigned long motion_events;
+    unsigned long button_events;
+    unsigned int last_motion; /* time of the last motion event */
+    /* pointer positions after each motion event, if path is not NULL */
+    Position *path;
+    int npath;
+    int path_allocated;
+} Stats;
+
+static void
+record_position (Stats *stats, unsigned int now, double dx, double dy)
+{
+    Position *position;
+
+    if (stats->npath == stats->path_allocated) {
+        stats->path_allocated *= 2;
+        stats->path = realloc(stats->path,
+                              stats->path_allocated * sizeof(*stats->path));
+        if (!stats->path) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+
+    position = &stats->path[stats->npath];
+    *position = stats->path[stats->npath - 1];
+    position->time = now;
+    position->x += dx;
+    position->y += dy;
+    stats->npath++;
+}
+
+static void
+account (Stats *stats, const PointingStickEvent *events, int n,
+         unsigned int now, int dump)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        const PointingStickEvent *event = &events[i];
+
+        if (event->type == POINTINGSTICK_EVENT_MOTION) {
+            stats->motion_events++;
+            stats->last_motion = now;
+            if (stats->path)
+                record_position(stats, now, event->dx, event->dy);
+            if (dump)
+                printf("%u motion %.3f %.3f\n", now, event->dx, event->dy);
+        } else {
+            stats->button_events++;
+            if (dump)
+                printf("%u button %d %d\n", now, event->button, event->pressed);
+        }
+    }
+}
+
+/*
+ * Motion held back by MotionRate, and a prediction to take back, is flushed
+ * at the time the driver's timer would fire, if that comes before the next
+ * frame.  predict 0 replays with PredictionHorizon forced off.
+ */
+static void
+replay (const Trace *trace, Stats *stats, int dump, int predict)
+{
+    PointingStickCore core;
+    PointingStickEvent events[POINTINGSTICK_MAX_EVENTS];
+    unsigned int now, due = 0;
+    int i, n, delay, flush_pending = 0;
+
+    init_core(&core, trace);
+    if (!predict)
+        core.prediction_horizon = 0;
+
+    for (i = 0; i < trace->nevents; i++) {
+        const struct input_event *ev = &trace->events[i];
+
+        if (!pointingstick_core_handle_event(&core, ev))
+            continue;
+
+        now = ev->time.tv_sec * 1000 + ev->time.tv_usec / 1000;
+        if (flush_pending && (int)(now - due) >= 0) {
+            n = pointingstick_core_flush_motion(&core, due, events);
+            account(stats, events, n, due, dump);
+        }
+
+        n = pointingstick_core_process_frame(&core, now, events);
+        stats->frames++;
+        account(stats, events, n, now, dump);
+
+        delay = pointingstick_core_motion_delay(&core, now);
+        flush_pending = delay >= 0;
+        due = now + delay;
+    }
+
+    if (flush_pending) {
+        n = pointingstick_core_flush_motion(&core, due, events);
+        account(stats, events, n, due, dump);
+    }
+}
+
+static void
+record_path (const Trace *trace, Stats *stats, int predict)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->path_allocated = 1024;
+    stats->path = calloc(stats->path_allocated, sizeof(*stats->path));
+    if (!stats->path) {
+        perror("calloc");
+        exit(1);
+    }
+    stats->npath = 1;
+    replay(trace, stats, 0, predict);
+}
+
+/* Where path puts the pointer at time, interpolating between events. */
+static void
+interpolate (const Stats *path, int *index, unsigned int time,
+             double *x, double *y)
+{
+    const Position *a, *b;
+    double f;
+
+    while (*index + 1 < path->npath && path->path[*index + 1].time <= time)
+        (*index)++;
+
+    a = &path->path[*index];
+    if (*index + 1 == path->npath || a->time == time) {
+        *x = a->x;
+        *y = a->y;
+        return;
+    }
+
+    b = &path->path[*index + 1];
+    f = (double)(time - a->time) / (b->time - a->time);
+    *x = a->x + (b->x - a->x) * f;
+    *y = a->y + (b->y - a->y) * f;
+}
+
+/*
+ * Compares the pointer position at each motion event with where the stick
+ * really is horizon ms later, interpolated between the reports replayed
+ * without prediction: a perfect predictor is always already there.  Not
+ * predicting at all is the baseline.
+ */
+static void
+measure_prediction (const Trace *trace)
+{
+    PointingStickCore core;
+    Stats real, predicted;
+    double error, error_sum = 0, error_max = 0;
+    double baseline, baseline_sum = 0, baseline_max = 0;
+    double now_x, now_y, ahead_x, ahead_y;
+    unsigned long samples = 0;
+    int i, now = 0, ahead = 0;
+
+    init_core(&core, trace);
+    if (core.prediction_horizon == 0) {
+        printf("%s: PredictionHorizon is off\n", trace->path);
+        return;
+    }
+
+    record_path(trace, &real, 0);
+    record_path(trace, &predicted, 1);
+
+    for (i = 1; i < predicted.npath; i++) {
+        const Position *p = &predicted.path[i];
+        unsigned int time = p->time + core.prediction_horizon;
+
+        /* only the last of several events at the same time is seen */
+        if (i + 1 < predicted.npath && predicted.path[i + 1].time == p->time)
+            continue;
+        if (time > real.path[real.npath - 1].time)
+            break;
+
+        interpolate(&real, &now, p->time, &now_x, &now_y);
+        interpolate(&real, &ahead, time, &ahead_x, &ahead_y);
+
+        error = hypot(p->x - ahead_x, p->y - ahead_y);
+        baseline = hypot(now_x - ahead_x, now_y - ahead_y);
+        if (error == 0 && baseline == 0)
+            continue;
+
+        error_sum += error;
+        baseline_sum += baseline;
+        if (error > error_max)
+            error_max = error;
+        if (baseline > baseline_max)
+            baseline_max = baseline;
+        samples++;
+    }
+
+    if (samples == 0)
+        printf("%s: no motion to predict\n", trace->path);
+    else
+        printf("%s: prediction error mean %.2f max %.2f, "
+               "without prediction mean %.2f max %.2f (%lu samples)\n",
+               trace->path, error_sum / samples, error_max,
+               baseline_sum / samples, baseline_max, samples);
+
+    free(real.path);
+    free(predicted.path);
+}
+
+static double
+now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void
+usage (const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [OPTION]... TRACE...\n"
+            "  -o, --option=NAME=VALUE  set a driver option, e.g. DriftCompensation=on\n"
+            "  -d, --dump               print the resulting pointer events\n"
+            "  -b, --bench=N            replay every trace N times and report the\n"
+            "                           cost per frame\n"
+            "  -e, --prediction-error   report how far PredictionHorizon puts the\n"
+            "                           pointer from where it really is that much later\n"
+            "  -s, --still-after=MS     fail if a trace posts motion after MS ms\n",
+            program);
+}
+
+int
+main (int argc, char **argv)
+{
+    static const struct option long_options[] = {
+        { "option", required_argument, NULL, 'o' },
+        { "dump", no_argument, NULL, 'd' },
+        { "bench", required_argument, NULL, 'b' },
+        { "prediction-error", no_argument, NULL, 'e' },
+        { "still-after", required_argument, NULL, 's' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int c, i, dump = 0, iterations = 0, prediction_error = 0;
+    int still_after = -1, failed = 0;
+
+    while ((c = getopt_long(argc, argv, "o:db:es:h", long_options, NULL)) != -1) {
+        switch (c) {
+        case 'o':
+            if (parse_setting(optarg) < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'd':
+            dump = 1;
+            break;
+        case 'b':
+            iterations = atoi(optarg);
+            break;
+        case 'e':
+            prediction_error = 1;
+            break;
+        case 's':
+            still_after = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind == argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    for (i = optind; i < argc; i++) {
+        Trace trace;
+        Stats stats;
+        int k;
+
+        if (load_trace(&trace, argv[i]) < 0)
+            return 1;
+
+        memset(&stats, 0, sizeof(stats));
+        replay(&trace, &stats, dump, 1);
+        printf("%s: %lu frames, %lu motion, %lu button events\n",
+               trace.path, stats.frames, stats.motion_events, stats.button_events);
+
+        if (still_after >= 0 && stats.motion_events > 0 &&
+            stats.last_motion > (unsigned int)still_after) {
+            printf("%s: still moving at %u ms\n", trace.path, stats.last_motion);
+            failed = 1;
+        }
+
+        if (iterations > 0 && stats.frames > 0) {
+            double start = now_ns();
+
+            for (k = 0; k < iterations; k++) {
+                Stats bench_stats;
+
+                memset(&bench_stats, 0, sizeof(bench_stats));
+                replay(&trace, &bench_stats, 0, 1);
+            }
+            printf("%s: %.1f ns/frame\n", trace.path,
+                   (now_ns() - start) / ((double)iterations * stats.frames));
+        }
+
+        if (prediction_error)
+            measure_prediction(&trace);
+
+        free(trace.events);
+    }
+
+    return failed;
+}
+
+/*
+vi:ts=4:nowrap:ai:expandtab:sw=4
+*/
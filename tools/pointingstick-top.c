@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2010 Hiroyuki Ikezoe
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Shows the live telemetry of a pointing stick driver instance configured
+ * with Option "Telemetry" "NAME".  It only maps the shared memory segment;
+ * neither an X connection nor anything on the server side is involved.
+ *
+ *   pointingstick-top [-n NAME] [-i INTERVAL] [-1]
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "pointingstick-telemetry.h"
+
+#define DEFAULT_INTERVAL 0.25
+
+static double
+now_s (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+per_second (unsigned int current, unsigned int previous, double elapsed)
+{
+    if (elapsed <= 0)
+        return 0;
+    return (unsigned int)(current - previous) / elapsed;
+}
+
+static void
+show (const char                   *name,
+      const PointingStickTelemetry *t,
+      const PointingStickTelemetry *last,
+      double                        elapsed,
+      int                           clear)
+{
+    if (clear)
+        printf("\033[H\033[2J");
+
+    printf("%s: %s\n\n", name, t->device_name);
+
+    printf("%-18s %10s %10s\n", "", "total", "per sec");
+    printf("%-18s %10u %10.1f\n", "frames",
+           t->frames, per_second(t->frames, last->frames, elapsed));
+    printf("%-18s %10u %10.1f\n", "empty frames",
+           t->suppressed_frames,
+           per_second(t->suppressed_frames, last->suppressed_frames, elapsed));
+    printf("%-18s %10u %10.1f\n", "motion events",
+           t->motion_events, per_second(t->motion_events, last->motion_events, elapsed));
+    printf("%-18s %10u %10.1f\n", "button changes",
+           t->button_events, per_second(t->button_events, last->button_events, elapsed));
+    printf("%-18s %10u %10.1f\n", "scroll clicks",
+           t->scroll_events, per_second(t->scroll_events, last->scroll_events, elapsed));
+    printf("%-18s %10u %10.1f\n", "read errors",
+           t->read_errors, per_second(t->read_errors, last->read_errors, elapsed));
+
+    printf("\nlast frame at %u ms\n", t->time);
+    printf("  raw          %6d %6d  pressure %d\n", t->x, t->y, t->pressure);
+    printf("  motion       %6.2f %6.2f\n", t->dx, t->dy);
+    printf("  buttons      %c%c%c%s%s\n",
+           t->buttons & 1 ? 'L' : '-',
+           t->buttons & 2 ? 'M' : '-',
+           t->buttons & 4 ? 'R' : '-',
+           t->scrolling ? "  scrolling" : "",
+           t->press_to_selecting ? "  press to select" : "");
+    printf("  drift        %6.2f %6.2f\n",
+           t->drift_baseline[0] / 256.0, t->drift_baseline[1] / 256.0);
+    if (t->report_rate > 0)
+        printf("  report rate  %d Hz\n", t->report_rate);
+    else
+        printf("  report rate  not managed\n");
+
+    fflush(stdout);
+}
+
+static void
+usage (const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [OPTION]...\n"
+            "  -n, --name=NAME          telemetry segment, as given to Option \"Telemetry\"\n"
+            "                           (default %s)\n"
+            "  -i, --interval=SECONDS   refresh interval (default %.2f)\n"
+            "  -1, --once               print one snapshot and exit\n",
+            program, POINTINGSTICK_TELEMETRY_DEFAULT_NAME, DEFAULT_INTERVAL);
+}
+
+int
+main (int argc, char **argv)
+{
+    static const struct option long_options[] = {
+        { "name", required_argument, NULL, 'n' },
+        { "interval", required_argument, NULL, 'i' },
+        { "once", no_argument, NULL, '1' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    const char *name = POINTINGSTICK_TELEMETRY_DEFAULT_NAME;
+    const PointingStickTelemetry *telemetry;
+    PointingStickTelemetry current, last;
+    double interval = DEFAULT_INTERVAL, then, now;
+    struct timespec delay;
+    int c, once = 0;
+
+    while ((c = getopt_long(argc, argv, "n:i:1h", long_options, NULL)) != -1) {
+        switch (c) {
+        case 'n':
+            name = optarg;
+            break;
+        case 'i':
+            interval = atof(optarg);
+            if (interval < 0.01)
+                interval = 0.01;
+            break;
+        case '1':
+            once = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    telemetry = pointingstick_telemetry_attach(name);
+    if (!telemetry) {
+        perror(name);
+        return 1;
+    }
+
+    if (pointingstick_telemetry_snapshot(telemetry, &last) < 0) {
+        fprintf(stderr, "%s: not a pointing stick telemetry segment\n", name);
+        return 1;
+    }
+    then = now_s();
+
+    if (once) {
+        show(name, &last, &last, 0, 0);
+        pointingstick_telemetry_detach(telemetry);
+        return 0;
+    }
+
+    delay.tv_sec = (time_t)interval;
+    delay.tv_nsec = (long)((interval - delay.tv_sec) * 1e9);
+
+    for (;;) {
+        nanosleep(&delay, NULL);
+
+        if (pointingstick_telemetry_snapshot(telemetry, &current) < 0) {
+            fprintf(stderr, "%s: segment went away\n", name);
+            break;
+        }
+        now = now_s();
+        show(name, &current, &last, now - then, 1);
+        last = current;
+        then = now;
+    }
+
+    pointingstick_telemetry_detach(telemetry);
+
+    return 1;
+}
+
+/*
+vi:ts=4:nowrap:ai:expandtab:sw=4
+*/
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2010 Hiroyuki Ikezoe
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of Red Hat
+ * not be used in advertising or publicity pertaining to distribution
+ * of the software without specific, written prior permission.  Red
+ * Hat makes no representations about the suitability of this software
+ * for any purpose.  It is provided "as is" without express or implied
+ * warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Times TrackPoint discovery and attribute access against a serio tree,
+ * typically one built by make-fake-sysfs.sh on tmpfs:
+ *
+ *   trackpoint-sysfs-bench ROOT [NAME] [ITERATIONS]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "trackpoint-sysfs.h"
+
+static double
+now_us (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void
+report (const char *what, double start, int iterations)
+{
+    printf("%-28s %10.2f us\n", what, (now_us() - start) / iterations);
+}
+
+int
+main (int argc, char **argv)
+{
+    static const char *attributes[] = {
+        "sensitivity",
+        "speed",
+        "press_to_select",
+        "thresh"
+    };
+    const char *root, *name;
+    char *path;
+    int iterations, i, j, value;
+    double start;
+
+    if (argc < 2 || argc > 4) {
+        fprintf(stderr, "Usage: %s ROOT [NAME] [ITERATIONS]\n", argv[0]);
+        return 1;
+    }
+    root = argv[1];
+    name = argc > 2 ? argv[2] : "TPPS/2 IBM TrackPoint";
+    iterations = argc > 3 ? atoi(argv[3]) : 1000;
+    if (iterations < 1)
+        iterations = 1;
+
+    path = trackpoint_sysfs_find(root, name);
+    if (!path) {
+        fprintf(stderr, "no TrackPoint named \"%s\" below %s\n", name, root);
+        return 1;
+    }
+    printf("found %s\n", path);
+
+    start = now_us();
+    for (i = 0; i < iterations; i++)
+        free(trackpoint_sysfs_find(root, name));
+    report("discovery", start, iterations);
+
+    start = now_us();
+    for (i = 0; i < iterations; i++) {
+        for (j = 0; j < 4; j++)
+            trackpoint_sysfs_get_attribute(path, attributes[j]);
+    }
+    report("read all settings", start, iterations);
+
+    value = trackpoint_sysfs_get_attribute(path, "sensitivity");
+    start = now_us();
+    for (i = 0; i < iterations; i++) {
+        if (trackpoint_sysfs_set_attribute(path, "sensitivity", value) < 0) {
+            fprintf(stderr, "cannot write %s/sensitivity\n", path);
+            break;
+        }
+    }
+    report("write one setting", start, iterations);
+
+    free(path);
+    return 0;
+}
+
+/*
+vi:ts=4:nowrap:ai:expandtab:sw=4
+*/